@@ -0,0 +1,271 @@
+#ifndef BROADCAST_CHANNEL_HPP_F8YB3NCE
+#define BROADCAST_CHANNEL_HPP_F8YB3NCE
+
+#include "channel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+template <std::copy_constructible T>
+class BroadcastSender;
+
+template <std::copy_constructible T>
+class BroadcastReceiver;
+
+namespace channel_detail
+{
+    // the value of a lag error is the number of messages the receiver missed (saturated at INT_MAX)
+    class LaggedCategory : public std::error_category
+    {
+    public:
+        const char* name() const noexcept override { return "broadcast_channel"; }
+
+        std::string message(int count) const override
+        {
+            return "receiver lagged behind by " + std::to_string(count) + " messages";
+        }
+    };
+
+    inline const std::error_category& laggedCategory()
+    {
+        static const LaggedCategory category;
+        return category;
+    }
+
+    inline std::error_code makeLaggedError(std::uint64_t count)
+    {
+        return { static_cast<int>(std::min<std::uint64_t>(count, INT_MAX)), laggedCategory() };
+    }
+}
+
+// returns the number of messages a BroadcastReceiver skipped if err is a lag error
+inline std::optional<std::size_t> laggedBy(const std::error_code& err)
+{
+    if (err.category() != channel_detail::laggedCategory()) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(err.value());
+}
+
+// every receiver sees every message. messages are stored once in a ring buffer and each receiver keeps its own
+// cursor into it. senders never block: when the ring is full the oldest message is overwritten, and a receiver that
+// was still behind it gets a lag error (see laggedBy) then continues from the oldest message still available.
+//
+// T must be copyable since each receiver gets its own copy.
+template <std::copy_constructible T>
+struct BroadcastChannel
+{
+    friend class BroadcastSender<T>;
+    friend class BroadcastReceiver<T>;
+
+public:
+    // capacity is rounded up to the next power of two
+    explicit BroadcastChannel(std::size_t capacity)
+        : m_mask{ std::bit_ceil(std::max(capacity, std::size_t{ 1 })) - 1 }
+        , m_slots{ std::make_unique<std::optional<T>[]>(m_mask + 1) }
+    {
+    }
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+private:
+    // must be called with m_mutex held
+    std::uint64_t oldest() const { return m_tail > m_mask ? m_tail - m_mask - 1 : 0; }
+
+    const std::size_t                   m_mask;
+    std::unique_ptr<std::optional<T>[]> m_slots;
+    std::uint64_t                       m_tail = 0;    // position of the next message, guarded by m_mutex
+
+    // senders take it exclusively, receivers only read the slots so they share it
+    std::shared_mutex           m_mutex;
+    std::condition_variable_any m_cv;
+
+    std::atomic<std::size_t> m_senders   = 0;
+    std::atomic<std::size_t> m_receivers = 0;
+};
+
+template <std::copy_constructible T>
+class BroadcastSender
+{
+public:
+    BroadcastSender(std::shared_ptr<BroadcastChannel<T>> channel)
+        : m_channel{ std::move(channel) }
+    {
+        m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~BroadcastSender() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            if (m_channel->m_senders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::unique_lock lock{ m_channel->m_mutex };
+            }
+            m_channel->m_cv.notify_all();
+            m_channel.reset();
+        }
+    }
+
+    BroadcastSender(const BroadcastSender& other)
+        : m_channel{ other.m_channel }
+    {
+        m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    BroadcastSender<T>& operator=(const BroadcastSender& other)
+    {
+        if (this != &other && m_channel != other.m_channel) {
+            close();
+            m_channel = other.m_channel;
+            m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    BroadcastSender(BroadcastSender&&)               = default;
+    BroadcastSender<T>& operator=(BroadcastSender&&) = default;
+
+    // never blocks, overwrites the oldest message if the ring is full. fails if there is no receiver.
+    CHANNEL_SEND_TYPE send(T&& value)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+        {
+            std::unique_lock lock{ channel.m_mutex };
+            if (channel.m_receivers.load() == 0) {
+                return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+            }
+            channel.m_slots[channel.m_tail & channel.m_mask] = std::move(value);
+            ++channel.m_tail;
+        }
+        channel.m_cv.notify_all();
+        return channel_detail::sendSuccess();
+    }
+
+    // the new receiver only sees the messages sent from now on
+    BroadcastReceiver<T> subscribe()
+    {
+        assert(m_channel);
+        std::shared_lock lock{ m_channel->m_mutex };
+        return { m_channel, m_channel->m_tail };
+    }
+
+private:
+    std::shared_ptr<BroadcastChannel<T>> m_channel;
+};
+
+template <std::copy_constructible T>
+class BroadcastReceiver
+{
+public:
+    BroadcastReceiver(std::shared_ptr<BroadcastChannel<T>> channel, std::uint64_t next)
+        : m_channel{ std::move(channel) }
+        , m_next{ next }
+    {
+        m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~BroadcastReceiver() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            m_channel->m_receivers.fetch_sub(1, std::memory_order_acq_rel);
+            m_channel.reset();
+        }
+    }
+
+    // the copy continues from the same position
+    BroadcastReceiver(const BroadcastReceiver& other)
+        : m_channel{ other.m_channel }
+        , m_next{ other.m_next }
+    {
+        m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    BroadcastReceiver<T>& operator=(const BroadcastReceiver& other)
+    {
+        if (this != &other) {
+            close();
+            m_channel = other.m_channel;
+            m_next    = other.m_next;
+            m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    BroadcastReceiver(BroadcastReceiver&&)               = default;
+    BroadcastReceiver<T>& operator=(BroadcastReceiver&&) = default;
+
+    // blocks until there is a message this receiver has not seen yet
+    CHANNEL_RECEIVE_TYPE(T) receive()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        std::shared_lock lock{ channel.m_mutex };
+        channel.m_cv.wait(lock, [&] { return m_next < channel.m_tail || channel.m_senders.load() == 0; });
+        return next();
+    }
+
+    // never blocks
+    CHANNEL_RECEIVE_TYPE(T) try_receive()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        std::shared_lock lock{ channel.m_mutex };
+        if (m_next == channel.m_tail && channel.m_senders.load() != 0) {
+            return channel_detail::receiveError<T>(std::errc::resource_unavailable_try_again, "receive on empty channel");
+        }
+        return next();
+    }
+
+private:
+    // must be called with the channel mutex held
+    CHANNEL_RECEIVE_TYPE(T) next()
+    {
+        auto& channel = *m_channel;
+
+        if (m_next == channel.m_tail) {
+            return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+        }
+        if (auto oldest = channel.oldest(); m_next < oldest) {
+            auto lag = oldest - m_next;
+            m_next   = oldest;
+            return channel_detail::receiveError<T>(channel_detail::makeLaggedError(lag), "receiver lagged behind");
+        }
+
+        auto value = T{ *channel.m_slots[m_next & channel.m_mask] };
+        ++m_next;
+        return channel_detail::receiveSuccess(std::move(value));
+    }
+
+    std::shared_ptr<BroadcastChannel<T>> m_channel;
+    std::uint64_t                        m_next;    // position of the next message to receive
+};
+
+// capacity is rounded up to the next power of two
+template <std::copy_constructible T>
+std::pair<BroadcastSender<T>, BroadcastReceiver<T>> makeBroadcastChannel(std::size_t capacity)
+{
+    auto channel = std::make_shared<BroadcastChannel<T>>(capacity);
+    return std::make_pair(BroadcastSender<T>{ channel }, BroadcastReceiver<T>{ channel, 0 });
+}
+
+#endif /* end of include guard: BROADCAST_CHANNEL_HPP_F8YB3NCE */
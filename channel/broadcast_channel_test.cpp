@@ -0,0 +1,44 @@
+#include "broadcast_channel.hpp"
+
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+
+void subscriber(BroadcastReceiver<int> rx, std::string name, std::chrono::milliseconds delay)
+{
+    while (true) {
+        auto [value, err] = rx.receive();
+        if (auto lag = laggedBy(err); lag) {
+            std::cout << std::format("{}: lagged, skipped {} messages\n", name, *lag);
+            continue;
+        } else if (err) {
+            std::cout << std::format("{}: {}\n", name, err.message());
+            break;
+        }
+        std::cout << std::format("{}: {}\n", name, value);
+        std::this_thread::sleep_for(delay);
+    }
+}
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    auto [tx, rx] = makeBroadcastChannel<int>(4);
+
+    std::jthread fast{ subscriber, tx.subscribe(), "fast", 0ms };
+    std::jthread slow{ subscriber, std::move(rx), "slow", 120ms };
+    std::jthread late;
+
+    for (int i = 0; i < 20; ++i) {
+        tx.send(int{ i });
+
+        // a late subscriber only sees what is sent after it subscribed
+        if (i == 10) {
+            late = std::jthread{ subscriber, tx.subscribe(), "late", 0ms };
+        }
+        std::this_thread::sleep_for(20ms);
+    }
+    tx.close();
+}
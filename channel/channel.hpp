@@ -1,14 +1,25 @@
 #ifndef CHANNEL_HPP_3QWAFGF4
 #define CHANNEL_HPP_3QWAFGF4
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <concepts>
+#include <cstdint>
 #include <condition_variable>
+#include <coroutine>
 #include <deque>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <optional>
+#include <ranges>
+#include <system_error>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #if defined(CHANNEL_RECEIVE_TYPE) or defined(CHANNEL_SEND_TYPE)
 #    error "CHANNEL_RECEIVE_TYPE or CHANNEL_SEND_TYPE should not be defined"
@@ -37,24 +48,573 @@
 #    error "CHANNEL_RECEIVE_TYPE should not be defined"
 #endif
 
+// define CHANNEL_STATS to 1 to make Channel keep the counters reported by Sender::stats and Receiver::stats. when it
+// is 0 (the default) none of the bookkeeping is compiled in.
+#if not defined(CHANNEL_STATS)
+#    define CHANNEL_STATS 0
+#endif
+
+namespace channel_detail
+{
+    // used to keep indices touched by different threads on separate cache lines
+    inline constexpr std::size_t s_cacheLineSize = 64;
+
+    // hint to the cpu that we are in a spin loop
+    inline void cpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+    // error codes used by the channels:
+    //  - std::errc::broken_pipe     : the other side of the channel is closed
+    //  - std::errc::no_buffer_space : a bounded channel is full (try_send, send_for, send_until)
+    //  - std::errc::resource_unavailable_try_again : the channel is empty (try_receive), or a slot claimed or peeked
+    //                                                 from an SpscChannel is still alive
+    //  - std::errc::timed_out       : the channel stayed empty until the deadline (receive_for, receive_until)
+    //  - std::errc::invalid_argument : a priority past the last lane (PrioritySender::send)
+    inline CHANNEL_SEND_TYPE sendError([[maybe_unused]] std::errc err, [[maybe_unused]] const char* what)
+    {
+#if CHANNEL_THROW
+        throw std::system_error{ std::make_error_code(err), what };
+#else
+        return std::make_error_code(err);
+#endif
+    }
+
+    inline CHANNEL_SEND_TYPE sendSuccess()
+    {
+#if CHANNEL_THROW
+        return;
+#else
+        return std::error_code{};
+#endif
+    }
+
+    // a thread blocked in select() on several channels, each of them bumps m_signal when it gets an element or its
+    // last sender closes. see select.hpp
+    struct SelectWaiter
+    {
+        std::mutex              m_mutex;
+        std::condition_variable m_cv;
+        std::uint64_t           m_signal = 0;
+
+        void notify()
+        {
+            {
+                std::unique_lock lock{ m_mutex };
+                ++m_signal;
+            }
+            m_cv.notify_one();
+        }
+    };
+
+    // keeps up to m_retained of the fixed-size blocks ("segments") std::deque stores its elements in on a free list
+    // instead of giving them back to the heap, so a queue that keeps growing and shrinking reuses its segments.
+    // only blocks of the first size given back are kept, the deque map is allocated from the heap as usual.
+    class SegmentPool
+    {
+    public:
+        SegmentPool(std::size_t retained, std::size_t alignment)
+            : m_retained{ retained }
+            , m_alignment{ alignment }
+        {
+        }
+
+        ~SegmentPool()
+        {
+            while (m_free) {
+                ::operator delete(std::exchange(m_free, m_free->m_next), m_alignment);
+            }
+        }
+
+        SegmentPool(const SegmentPool&)            = delete;
+        SegmentPool& operator=(const SegmentPool&) = delete;
+
+        void* allocate(std::size_t bytes)
+        {
+            {
+                std::unique_lock lock{ m_mutex };
+                if (m_free && bytes == m_bytes) {
+                    --m_count;
+                    return std::exchange(m_free, m_free->m_next);
+                }
+            }
+            return ::operator new(bytes, m_alignment);
+        }
+
+        void deallocate(void* block, std::size_t bytes)
+        {
+            if (bytes >= sizeof(FreeBlock)) {
+                std::unique_lock lock{ m_mutex };
+                if (m_count < m_retained && (m_bytes == 0 || m_bytes == bytes)) {
+                    m_bytes = bytes;
+                    m_free  = ::new (block) FreeBlock{ m_free };
+                    ++m_count;
+                    return;
+                }
+            }
+            ::operator delete(block, m_alignment);
+        }
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock* m_next;
+        };
+
+        std::mutex             m_mutex;
+        FreeBlock*             m_free  = nullptr;
+        std::size_t            m_count = 0;
+        std::size_t            m_bytes = 0;
+        const std::size_t      m_retained;
+        const std::align_val_t m_alignment;
+    };
+
+    // allocator of the Channel queue. blocks of Element (the deque segments) go through the pool when there is one,
+    // anything else (the deque map) goes to the heap.
+    template <typename U, typename Element>
+    class SegmentAllocator
+    {
+    public:
+        template <typename, typename>
+        friend class SegmentAllocator;
+
+        using value_type = U;
+
+        template <typename V>
+        struct rebind
+        {
+            using other = SegmentAllocator<V, Element>;
+        };
+
+        SegmentAllocator() = default;
+
+        explicit SegmentAllocator(std::shared_ptr<SegmentPool> pool)
+            : m_pool{ std::move(pool) }
+        {
+        }
+
+        // a moved-from allocator must still be equal to the new one, so there is no move constructor
+        SegmentAllocator(const SegmentAllocator&)            = default;
+        SegmentAllocator& operator=(const SegmentAllocator&) = default;
+
+        template <typename V>
+        SegmentAllocator(const SegmentAllocator<V, Element>& other)
+            : m_pool{ other.m_pool }
+        {
+        }
+
+        U* allocate(std::size_t n)
+        {
+            if constexpr (std::same_as<U, Element>) {
+                if (m_pool) {
+                    return static_cast<U*>(m_pool->allocate(n * sizeof(U)));
+                }
+            }
+            return std::allocator<U>{}.allocate(n);
+        }
+
+        void deallocate(U* pointer, std::size_t n)
+        {
+            if constexpr (std::same_as<U, Element>) {
+                if (m_pool) {
+                    return m_pool->deallocate(pointer, n * sizeof(U));
+                }
+            }
+            std::allocator<U>{}.deallocate(pointer, n);
+        }
+
+        template <typename V>
+        bool operator==(const SegmentAllocator<V, Element>& other) const
+        {
+            return m_pool == other.m_pool;
+        }
+
+    private:
+        std::shared_ptr<SegmentPool> m_pool;
+    };
+
+    template <typename T, typename Handler>
+    class ReceiveCase;
+
+    // a coroutine suspended in async_receive/async_send, linked into an intrusive FIFO owned by the channel so
+    // suspending never allocates. the node lives in the awaiter, inside the coroutine frame.
+    struct AsyncWaiter
+    {
+        AsyncWaiter*            m_next = nullptr;
+        std::coroutine_handle<> m_handle;
+        std::errc               m_error{};    // std::errc{} means success
+
+        // resumes m_handle on the executor given to async_receive/async_send
+        virtual void resume() = 0;
+
+    protected:
+        ~AsyncWaiter() = default;
+    };
+
+    template <typename T>
+    struct AsyncReceiveWaiter : AsyncWaiter
+    {
+        std::optional<T> m_value;
+
+    protected:
+        ~AsyncReceiveWaiter() = default;
+    };
+
+    template <typename T>
+    struct AsyncSendWaiter : AsyncWaiter
+    {
+        T m_value;
+
+        AsyncSendWaiter(T&& value)
+            : m_value{ std::move(value) }
+        {
+        }
+
+    protected:
+        ~AsyncSendWaiter() = default;
+    };
+
+    template <typename Waiter>
+    class AsyncWaiterQueue
+    {
+    public:
+        bool empty() const { return m_head == nullptr; }
+
+        void push(Waiter& waiter)
+        {
+            waiter.m_next = nullptr;
+            if (m_tail) {
+                m_tail->m_next = &waiter;
+            } else {
+                m_head = &waiter;
+            }
+            m_tail = &waiter;
+        }
+
+        Waiter& pop()
+        {
+            auto* waiter = m_head;
+            m_head       = static_cast<Waiter*>(waiter->m_next);
+            if (!m_head) {
+                m_tail = nullptr;
+            }
+            return *waiter;
+        }
+
+        // must be called without the channel mutex held, the coroutines may use the channel again right away.
+        // a waiter must not be touched once resumed since its coroutine frame may be gone.
+        void resumeAll()
+        {
+            while (!empty()) {
+                pop().resume();
+            }
+        }
+
+    private:
+        Waiter* m_head = nullptr;
+        Waiter* m_tail = nullptr;
+    };
+
+    using ResumeQueue = AsyncWaiterQueue<AsyncWaiter>;
+
+    template <typename T, typename Executor>
+    class ReceiveAwaiter;
+
+    template <typename T, typename Executor>
+    class SendAwaiter;
+
+    template <typename T>
+    CHANNEL_RECEIVE_TYPE(T) receiveError([[maybe_unused]] std::error_code err, [[maybe_unused]] const char* what)
+    {
+#if CHANNEL_THROW
+        throw std::system_error{ err, what };
+#elif CHANNEL_EXPECTED
+        return std::unexpected{ err };
+#else
+        return std::make_pair(T{}, err);
+#endif
+    }
+
+    template <typename T>
+    CHANNEL_RECEIVE_TYPE(T) receiveError(std::errc err, const char* what)
+    {
+        return receiveError<T>(std::make_error_code(err), what);
+    }
+
+    template <typename T>
+    CHANNEL_RECEIVE_TYPE(T) receiveSuccess(T&& value)
+    {
+#if CHANNEL_THROW
+        return std::move(value);
+#elif CHANNEL_EXPECTED
+        return std::expected<T, std::error_code>{ std::move(value) };
+#else
+        return std::make_pair(std::move(value), std::error_code{});
+#endif
+    }
+}
+
+#if CHANNEL_STATS
+// a snapshot of the Channel counters, taking it never blocks the channel
+struct ChannelStats
+{
+    std::size_t              depth;                 // elements currently queued
+    std::size_t              highWaterDepth;        // most elements ever queued at once
+    std::uint64_t            sent;
+    std::uint64_t            received;
+    std::chrono::nanoseconds receiverWaitTime;      // total time receivers spent blocked waiting for elements
+    std::chrono::nanoseconds senderLockWaitTime;    // total time senders spent waiting for the channel mutex
+    std::uint64_t            lockCollisions;        // acquisitions of the channel mutex that found it already taken
+};
+
+namespace channel_detail
+{
+    // written with m_mutex held (apart from the wait times), read from anywhere
+    struct StatsCounters
+    {
+        std::atomic<std::size_t>   m_highWaterDepth     = 0;
+        std::atomic<std::uint64_t> m_sent               = 0;
+        std::atomic<std::uint64_t> m_received           = 0;
+        std::atomic<std::int64_t>  m_receiverWaitTime   = 0;
+        std::atomic<std::int64_t>  m_senderLockWaitTime = 0;
+        std::atomic<std::uint64_t> m_lockCollisions     = 0;
+
+        ChannelStats snapshot(std::size_t depth) const
+        {
+            return {
+                .depth              = depth,
+                .highWaterDepth     = m_highWaterDepth.load(std::memory_order_relaxed),
+                .sent               = m_sent.load(std::memory_order_relaxed),
+                .received           = m_received.load(std::memory_order_relaxed),
+                .receiverWaitTime   = std::chrono::nanoseconds{ m_receiverWaitTime.load(std::memory_order_relaxed) },
+                .senderLockWaitTime = std::chrono::nanoseconds{ m_senderLockWaitTime.load(std::memory_order_relaxed) },
+                .lockCollisions     = m_lockCollisions.load(std::memory_order_relaxed),
+            };
+        }
+    };
+}
+#endif
+
 template <std::move_constructible T>
 class Sender;
 
 template <std::move_constructible T>
 class Receiver;
 
+// resumes the coroutine right away on the thread that completed the operation
+struct InlineExecutor
+{
+    void operator()(std::coroutine_handle<> handle) const { handle.resume(); }
+};
+
+template <typename E>
+concept ChannelExecutor = std::invocable<E&, std::coroutine_handle<>>;
+
+// how a Receiver waits for an empty channel: check up to spinCount times with a pause instruction in between, then
+// up to yieldCount times with std::this_thread::yield, and only then block on the condition variable. spinning
+// avoids the futex syscall and scheduler wake-up when the next element is only a few hundred nanoseconds away, at
+// the cost of burning a core meanwhile. the default parks right away.
+struct WaitPolicy
+{
+    std::uint32_t spinCount  = 0;
+    std::uint32_t yieldCount = 0;
+};
+
+// a capacity of 0 means the channel is unbounded
 template <std::move_constructible T>
 struct Channel
 {
     friend class Sender<T>;
     friend class Receiver<T>;
 
+    template <typename, typename>
+    friend class channel_detail::ReceiveAwaiter;
+
+    template <typename, typename>
+    friend class channel_detail::SendAwaiter;
+
+public:
+    using Queue_type = std::deque<T, channel_detail::SegmentAllocator<T, T>>;
+
+    // retainedSegments > 0 makes the queue recycle up to that many of its segments instead of freeing them, so once
+    // the queue has grown to its usual size send and receive stop allocating.
+    explicit Channel(std::size_t capacity = 0, std::size_t retainedSegments = 0)
+        : m_queue{ typename Queue_type::allocator_type{
+            retainedSegments > 0 ? std::make_shared<channel_detail::SegmentPool>(retainedSegments, alignof(T)) : nullptr,
+        } }
+        , m_capacity{ capacity }
+    {
+    }
+
 private:
-    std::deque<T>            m_queue;
+    Queue_type               m_queue;
     std::mutex               m_mutex;
-    std::condition_variable  m_cv;
+    std::condition_variable  m_cv;        // notified when an element is pushed or a sender closed
+    std::condition_variable  m_sendCv;    // notified when an element is popped or a receiver closed
+    std::size_t              m_capacity;
     std::atomic<std::size_t> m_senders   = 0;
     std::atomic<std::size_t> m_receivers = 0;
+    std::atomic<std::size_t> m_size      = 0;    // m_queue.size(), for spinning receivers to look at without the lock
+    std::size_t              m_parked    = 0;    // receivers blocked on m_cv, senders skip the notify when there are none
+
+    std::vector<channel_detail::SelectWaiter*> m_selectors;
+
+    // coroutines suspended in async_receive (channel empty) and async_send (channel full)
+    channel_detail::AsyncWaiterQueue<channel_detail::AsyncReceiveWaiter<T>> m_asyncReceivers;
+    channel_detail::AsyncWaiterQueue<channel_detail::AsyncSendWaiter<T>>    m_asyncSenders;
+
+#if CHANNEL_STATS
+    channel_detail::StatsCounters m_stats;
+#endif
+
+    std::unique_lock<std::mutex> lockFromSender()
+    {
+#if CHANNEL_STATS
+        std::unique_lock lock{ m_mutex, std::try_to_lock };
+        if (!lock.owns_lock()) {
+            auto start = std::chrono::steady_clock::now();
+            lock.lock();
+            auto waited = std::chrono::steady_clock::now() - start;
+            m_stats.m_lockCollisions.fetch_add(1, std::memory_order_relaxed);
+            m_stats.m_senderLockWaitTime.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(), std::memory_order_relaxed
+            );
+        }
+        return lock;
+#else
+        return std::unique_lock{ m_mutex };
+#endif
+    }
+
+    std::unique_lock<std::mutex> lockFromReceiver()
+    {
+#if CHANNEL_STATS
+        std::unique_lock lock{ m_mutex, std::try_to_lock };
+        if (!lock.owns_lock()) {
+            m_stats.m_lockCollisions.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+        }
+        return lock;
+#else
+        return std::unique_lock{ m_mutex };
+#endif
+    }
+
+    // m_cv.wait for receivers, the time spent blocked is recorded
+    template <typename Clock, typename Duration, typename Pred>
+    bool waitForElementsUntil(
+        std::unique_lock<std::mutex>&                   lock,
+        const std::chrono::time_point<Clock, Duration>* deadline,
+        Pred                                            pred
+    )
+    {
+#if CHANNEL_STATS
+        if (pred()) {
+            return true;
+        }
+        auto start = std::chrono::steady_clock::now();
+#endif
+        auto ready = true;
+        ++m_parked;
+        if (deadline) {
+            ready = m_cv.wait_until(lock, *deadline, pred);
+        } else {
+            m_cv.wait(lock, pred);
+        }
+        --m_parked;
+#if CHANNEL_STATS
+        auto waited = std::chrono::steady_clock::now() - start;
+        m_stats.m_receiverWaitTime.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(), std::memory_order_relaxed
+        );
+#endif
+        return ready;
+    }
+
+    template <typename Pred>
+    void waitForElements(std::unique_lock<std::mutex>& lock, Pred pred)
+    {
+        waitForElementsUntil<std::chrono::steady_clock, std::chrono::steady_clock::duration>(lock, nullptr, pred);
+    }
+
+    // must be called with m_mutex held, after the queue changed
+    void recordSent([[maybe_unused]] std::size_t count)
+    {
+        auto depth = m_queue.size();
+        m_size.store(depth, std::memory_order_relaxed);
+#if CHANNEL_STATS
+        m_stats.m_sent.fetch_add(count, std::memory_order_relaxed);
+        if (depth > m_stats.m_highWaterDepth.load(std::memory_order_relaxed)) {
+            m_stats.m_highWaterDepth.store(depth, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    // must be called with m_mutex held, after the queue changed
+    void recordReceived([[maybe_unused]] std::size_t count)
+    {
+        m_size.store(m_queue.size(), std::memory_order_relaxed);
+#if CHANNEL_STATS
+        m_stats.m_received.fetch_add(count, std::memory_order_relaxed);
+#endif
+    }
+
+    // must be called with m_mutex held
+    bool full() const { return m_capacity != 0 && m_queue.size() >= m_capacity; }
+
+    // must be called with m_mutex held
+    void notifySelectors()
+    {
+        for (auto* selector : m_selectors) {
+            selector->notify();
+        }
+    }
+
+    // must be called with m_mutex held. hands value directly to a suspended async receiver if there is one,
+    // otherwise queues it. the receiver is added to resumable.
+    void push(T&& value, channel_detail::ResumeQueue& resumable)
+    {
+        if (!m_asyncReceivers.empty()) {
+            auto& waiter = m_asyncReceivers.pop();
+            waiter.m_value.emplace(std::move(value));
+            resumable.push(waiter);
+            recordSent(1);
+            recordReceived(1);
+            return;
+        }
+        m_queue.push_back(std::move(value));
+        recordSent(1);
+        notifySelectors();
+    }
+
+    // must be called with m_mutex held after elements are popped. moves the values of suspended async senders into
+    // the freed space, the senders are added to resumable.
+    void refill(channel_detail::ResumeQueue& resumable)
+    {
+        while (!m_asyncSenders.empty() && !full()) {
+            auto& waiter = m_asyncSenders.pop();
+            m_queue.push_back(std::move(waiter.m_value));
+            recordSent(1);
+            notifySelectors();
+            resumable.push(waiter);
+        }
+    }
+
+    // must be called with m_mutex held. fails every suspended waiter in waiters with broken_pipe.
+    template <typename Waiter>
+    static void breakAll(channel_detail::AsyncWaiterQueue<Waiter>& waiters, channel_detail::ResumeQueue& resumable)
+    {
+        while (!waiters.empty()) {
+            auto& waiter   = waiters.pop();
+            waiter.m_error = std::errc::broken_pipe;
+            resumable.push(waiter);
+        }
+    }
 };
 
 template <std::move_constructible T>
@@ -72,9 +632,18 @@ public:
     void close()
     {
         if (m_channel) {
-            auto count = m_channel->m_senders.fetch_sub(1, std::memory_order_acq_rel);
-            m_channel->m_cv.notify_all();
+            auto count     = m_channel->m_senders.fetch_sub(1, std::memory_order_acq_rel);
+            auto resumable = channel_detail::ResumeQueue{};
+            if (count == 1) {
+                {
+                    std::unique_lock lock{ m_channel->m_mutex };
+                    m_channel->notifySelectors();
+                    Channel<T>::breakAll(m_channel->m_asyncReceivers, resumable);
+                }
+                m_channel->m_cv.notify_all();
+            }
             m_channel.reset();
+            resumable.resumeAll();
         }
     }
 
@@ -99,29 +668,155 @@ public:
     Sender(Sender&&)               = default;
     Sender<T>& operator=(Sender&&) = default;
 
+    // blocks while a bounded channel is full
     CHANNEL_SEND_TYPE send(T&& value)
     {
         assert(m_channel);
-        auto& [queue, mutex, cv, sc, rc] = *m_channel;
+        auto& channel = *m_channel;
+
+        auto resumable = channel_detail::ResumeQueue{};
+        auto parked    = false;
         {
-            std::unique_lock lock{ m_channel->m_mutex };
-            if (rc.load() == 0) {
-#if CHANNEL_THROW
-                throw std::runtime_error{ "receive on closed channel" };
-#else
-                return std::make_error_code(std::errc::broken_pipe);
-#endif
+            auto lock = channel.lockFromSender();
+            channel.m_sendCv.wait(lock, [&] { return !channel.full() || channel.m_receivers.load() == 0; });
+
+            if (channel.m_receivers.load() == 0) {
+                return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
             }
-            queue.push_back(std::move(value));
+            channel.push(std::move(value), resumable);
+            parked = channel.m_parked != 0;
         }
-        m_channel->m_cv.notify_one();
-#if CHANNEL_THROW
-        return;
-#else
-        return std::error_code{};
-#endif
+        if (parked) {
+            channel.m_cv.notify_one();
+        }
+        resumable.resumeAll();
+        return channel_detail::sendSuccess();
+    }
+
+    // never blocks; if the channel is full, value is left untouched
+    CHANNEL_SEND_TYPE try_send(T&& value)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto resumable = channel_detail::ResumeQueue{};
+        auto parked    = false;
+        {
+            auto lock = channel.lockFromSender();
+            if (channel.m_receivers.load() == 0) {
+                return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+            }
+            if (channel.full()) {
+                return channel_detail::sendError(std::errc::no_buffer_space, "send on full channel");
+            }
+            channel.push(std::move(value), resumable);
+            parked = channel.m_parked != 0;
+        }
+        if (parked) {
+            channel.m_cv.notify_one();
+        }
+        resumable.resumeAll();
+        return channel_detail::sendSuccess();
     }
 
+    // blocks until there is space or the deadline is reached; on timeout, value is left untouched
+    template <typename Clock, typename Duration>
+    CHANNEL_SEND_TYPE send_until(T&& value, const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto resumable = channel_detail::ResumeQueue{};
+        auto parked    = false;
+        {
+            auto lock = channel.lockFromSender();
+            auto ready = channel.m_sendCv.wait_until(lock, deadline, [&] {
+                return !channel.full() || channel.m_receivers.load() == 0;
+            });
+
+            if (channel.m_receivers.load() == 0) {
+                return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+            }
+            if (!ready) {
+                return channel_detail::sendError(std::errc::no_buffer_space, "send on full channel");
+            }
+            channel.push(std::move(value), resumable);
+            parked = channel.m_parked != 0;
+        }
+        if (parked) {
+            channel.m_cv.notify_one();
+        }
+        resumable.resumeAll();
+        return channel_detail::sendSuccess();
+    }
+
+    template <typename Rep, typename Period>
+    CHANNEL_SEND_TYPE send_for(T&& value, const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return send_until(std::move(value), std::chrono::steady_clock::now() + timeout);
+    }
+
+    // moves every element of range into the channel under a single lock, receivers are notified once at the end.
+    // on a bounded channel this blocks whenever the channel gets full until receivers make room for the rest.
+    template <std::ranges::input_range R>
+        requires std::convertible_to<std::ranges::range_rvalue_reference_t<R>, T>
+    CHANNEL_SEND_TYPE sendMany(R&& range)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto first     = std::ranges::begin(range);
+        auto last      = std::ranges::end(range);
+        auto closed    = false;
+        auto resumable = channel_detail::ResumeQueue{};
+        auto parked    = false;
+        {
+            auto lock = channel.lockFromSender();
+            do {
+                if (channel.full()) {
+                    if (channel.m_parked != 0) {
+                        channel.m_cv.notify_all();
+                    }
+                    channel.m_sendCv.wait(lock, [&] { return !channel.full() || channel.m_receivers.load() == 0; });
+                }
+                if (channel.m_receivers.load() == 0) {
+                    closed = true;
+                    break;
+                }
+                for (; first != last && !channel.full(); ++first) {
+                    channel.push(std::ranges::iter_move(first), resumable);
+                }
+            } while (first != last);
+            parked = channel.m_parked != 0;
+        }
+        if (parked) {
+            channel.m_cv.notify_all();
+        }
+        resumable.resumeAll();
+
+        if (closed) {
+            return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+        }
+        return channel_detail::sendSuccess();
+    }
+
+    // co_await sender.async_send(std::move(value)) suspends the coroutine instead of blocking while a bounded
+    // channel is full. the coroutine is resumed through executor by the receiver that makes room for the value.
+    template <ChannelExecutor Executor = InlineExecutor>
+    channel_detail::SendAwaiter<T, Executor> async_send(T&& value, Executor executor = {})
+    {
+        assert(m_channel);
+        return { m_channel, std::move(value), std::move(executor) };
+    }
+
+#if CHANNEL_STATS
+    ChannelStats stats() const
+    {
+        assert(m_channel);
+        return m_channel->m_stats.snapshot(m_channel->m_size.load(std::memory_order_relaxed));
+    }
+#endif
+
 private:
     std::shared_ptr<Channel<T>> m_channel;
 };
@@ -129,7 +824,12 @@ private:
 template <std::move_constructible T>
 class Receiver
 {
+    template <typename, typename>
+    friend class channel_detail::ReceiveCase;
+
 public:
+    using Queue_type = Channel<T>::Queue_type;
+
     Receiver(std::shared_ptr<Channel<T>> channel)
         : m_channel{ std::move(channel) }
     {
@@ -141,9 +841,17 @@ public:
     void close()
     {
         if (m_channel) {
-            m_channel->m_receivers.fetch_sub(1);
-            m_channel->m_cv.notify_all();
+            auto count     = m_channel->m_receivers.fetch_sub(1);
+            auto resumable = channel_detail::ResumeQueue{};
+            if (count == 1) {
+                {
+                    std::unique_lock lock{ m_channel->m_mutex };
+                    Channel<T>::breakAll(m_channel->m_asyncSenders, resumable);
+                }
+                m_channel->m_sendCv.notify_all();
+            }
             m_channel.reset();
+            resumable.resumeAll();
         }
     }
 
@@ -156,41 +864,353 @@ public:
     CHANNEL_RECEIVE_TYPE(T) receive()
     {
         assert(m_channel);
-        auto& [queue, mutex, cv, sc, rc] = *m_channel;
+        auto& channel = *m_channel;
+
+        spin();
+        auto lock = channel.lockFromReceiver();
+        if (channel.m_queue.empty()) {
+            channel.waitForElements(lock, [&] { return !channel.m_queue.empty() || channel.m_senders.load() == 0; });
+
+            // the last sender may have sent and closed before this woke up, what it sent is still received
+            if (channel.m_queue.empty()) {
+                return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+            }
+        }
+        return pop(lock);
+    }
+
+    // never blocks
+    CHANNEL_RECEIVE_TYPE(T) try_receive()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto lock = channel.lockFromReceiver();
+        if (channel.m_queue.empty()) {
+            if (channel.m_senders.load() == 0) {
+                return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+            }
+            return channel_detail::receiveError<T>(std::errc::resource_unavailable_try_again, "receive on empty channel");
+        }
+        return pop(lock);
+    }
+
+    template <typename Clock, typename Duration>
+    CHANNEL_RECEIVE_TYPE(T) receive_until(const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto lock = channel.lockFromReceiver();
+        auto ready = channel.waitForElementsUntil(lock, &deadline, [&] {
+            return !channel.m_queue.empty() || channel.m_senders.load() == 0;
+        });
+
+        if (!ready) {
+            return channel_detail::receiveError<T>(std::errc::timed_out, "receive timed out");
+        }
+        if (channel.m_queue.empty()) {
+            return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+        }
+        return pop(lock);
+    }
+
+    template <typename Rep, typename Period>
+    CHANNEL_RECEIVE_TYPE(T) receive_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return receive_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // blocks until at least one element is available, then moves up to maxCount elements into out under a single
+    // lock. returns the number of elements received.
+    template <std::output_iterator<T> Out>
+    CHANNEL_RECEIVE_TYPE(std::size_t) receiveMany(Out out, std::size_t maxCount)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        spin();
+        auto lock = channel.lockFromReceiver();
+        channel.waitForElements(lock, [&] { return !channel.m_queue.empty() || channel.m_senders.load() == 0; });
+
+        if (channel.m_queue.empty()) {
+            return channel_detail::receiveError<std::size_t>(std::errc::broken_pipe, "receive on closed channel");
+        }
+
+        auto count = std::min(maxCount, channel.m_queue.size());
+        auto first = channel.m_queue.begin();
+        auto last  = first + static_cast<std::ptrdiff_t>(count);
+        std::move(first, last, out);
+        channel.m_queue.erase(first, last);
+        channel.recordReceived(count);
+
+        auto resumable = channel_detail::ResumeQueue{};
+        channel.refill(resumable);
+        lock.unlock();
+
+        if (channel.m_capacity != 0) {
+            channel.m_sendCv.notify_all();
+        }
+        resumable.resumeAll();
+        return channel_detail::receiveSuccess(std::size_t{ count });
+    }
+
+    // never blocks, takes everything currently queued (which may be nothing). fails only if the channel is both
+    // empty and closed.
+    CHANNEL_RECEIVE_TYPE(Queue_type) drain()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto values    = Queue_type{ channel.m_queue.get_allocator() };
+        auto resumable = channel_detail::ResumeQueue{};
         {
-            std::unique_lock lock{ m_channel->m_mutex };
-            if (queue.empty()) {
-                m_channel->m_cv.wait(lock, [&] { return !queue.empty() || sc.load() == 0; });
+            auto lock = channel.lockFromReceiver();
+            if (channel.m_queue.empty() && channel.m_senders.load() == 0) {
+                return channel_detail::receiveError<Queue_type>(std::errc::broken_pipe, "receive on closed channel");
+            }
+            values.swap(channel.m_queue);
+            channel.recordReceived(values.size());
+            channel.refill(resumable);
+        }
 
-                if (sc.load() == 0) {
-#if CHANNEL_THROW
-                    throw std::runtime_error{ "receive on closed channel" };
-#elif CHANNEL_EXPECTED
-                    return std::unexpected{ std::make_error_code(std::errc::broken_pipe) };
-#else
-                    return std::make_pair(T{}, std::make_error_code(std::errc::broken_pipe));
+        if (channel.m_capacity != 0 && !values.empty()) {
+            channel.m_sendCv.notify_all();
+        }
+        resumable.resumeAll();
+        return channel_detail::receiveSuccess(std::move(values));
+    }
+
+    // applies to receive and receiveMany, the timed receives always park right away
+    void setWaitPolicy(WaitPolicy policy) { m_waitPolicy = policy; }
+
+    // co_await receiver.async_receive() suspends the coroutine instead of blocking while the channel is empty. the
+    // coroutine is resumed through executor by the sender that hands it a value (or by the last sender closing).
+    template <ChannelExecutor Executor = InlineExecutor>
+    channel_detail::ReceiveAwaiter<T, Executor> async_receive(Executor executor = {})
+    {
+        assert(m_channel);
+        return { m_channel, std::move(executor) };
+    }
+
+#if CHANNEL_STATS
+    ChannelStats stats() const
+    {
+        assert(m_channel);
+        return m_channel->m_stats.snapshot(m_channel->m_size.load(std::memory_order_relaxed));
+    }
 #endif
-                }
+
+private:
+    // waits according to m_waitPolicy for the channel to look non-empty or closed, without taking the lock
+    void spin() const
+    {
+        auto& channel = *m_channel;
+        auto  ready   = [&] {
+            return channel.m_size.load(std::memory_order_relaxed) != 0
+                || channel.m_senders.load(std::memory_order_relaxed) == 0;
+        };
+
+        for (auto i = 0u; i < m_waitPolicy.spinCount; ++i) {
+            if (ready()) {
+                return;
+            }
+            channel_detail::cpuRelax();
+        }
+        for (auto i = 0u; i < m_waitPolicy.yieldCount; ++i) {
+            if (ready()) {
+                return;
             }
-            auto value = std::move(queue.front());
-            queue.pop_front();
+            std::this_thread::yield();
+        }
+    }
 
-#if CHANNEL_EXPECTED
-            return std::expected<T, std::error_code>{ std::move(value) };
-#else
-            return std::make_pair(std::move(value), std::error_code{});
-#endif
+    // used by select: hands the next element, or the broken_pipe error once the channel is closed and empty, to
+    // handler. returns false without calling handler if the channel is empty but still open.
+    template <typename Handler>
+    bool poll(Handler& handler)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto lock = channel.lockFromReceiver();
+        if (channel.m_queue.empty()) {
+            if (channel.m_senders.load() != 0) {
+                return false;
+            }
+            lock.unlock();
+            handler(channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel"));
+            return true;
         }
+        handler(pop(lock));
+        return true;
+    }
+
+    void addSelector(channel_detail::SelectWaiter& selector)
+    {
+        std::unique_lock lock{ m_channel->m_mutex };
+        m_channel->m_selectors.push_back(&selector);
+    }
+
+    void removeSelector(channel_detail::SelectWaiter& selector)
+    {
+        std::unique_lock lock{ m_channel->m_mutex };
+        std::erase(m_channel->m_selectors, &selector);
+    }
+
+    // lock must hold the channel mutex and the queue must not be empty
+    CHANNEL_RECEIVE_TYPE(T) pop(std::unique_lock<std::mutex>& lock)
+    {
+        auto& channel = *m_channel;
+
+        auto value = std::move(channel.m_queue.front());
+        channel.m_queue.pop_front();
+        channel.recordReceived(1);
+
+        auto resumable = channel_detail::ResumeQueue{};
+        channel.refill(resumable);
+        lock.unlock();
+
+        if (channel.m_capacity != 0) {
+            channel.m_sendCv.notify_one();
+        }
+        resumable.resumeAll();
+        return channel_detail::receiveSuccess(std::move(value));
     }
 
-private:
     std::shared_ptr<Channel<T>> m_channel;
+    WaitPolicy                  m_waitPolicy;
 };
 
+namespace channel_detail
+{
+    template <typename T, typename Executor>
+    class ReceiveAwaiter : public AsyncReceiveWaiter<T>
+    {
+    public:
+        ReceiveAwaiter(std::shared_ptr<Channel<T>> channel, Executor executor)
+            : m_channel{ std::move(channel) }
+            , m_executor{ std::move(executor) }
+        {
+        }
+
+        ReceiveAwaiter(const ReceiveAwaiter&)            = delete;
+        ReceiveAwaiter& operator=(const ReceiveAwaiter&) = delete;
+
+        bool await_ready() const noexcept { return false; }
+
+        // returns false (not suspending) if the result is available right away
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            auto& channel = *m_channel;
+
+            auto lock = channel.lockFromReceiver();
+            if (!channel.m_queue.empty()) {
+                this->m_value.emplace(std::move(channel.m_queue.front()));
+                channel.m_queue.pop_front();
+                channel.recordReceived(1);
+
+                auto resumable = ResumeQueue{};
+                channel.refill(resumable);
+                lock.unlock();
+
+                if (channel.m_capacity != 0) {
+                    channel.m_sendCv.notify_one();
+                }
+                resumable.resumeAll();
+                return false;
+            }
+            if (channel.m_senders.load() == 0) {
+                this->m_error = std::errc::broken_pipe;
+                return false;
+            }
+
+            this->m_handle = handle;
+            channel.m_asyncReceivers.push(*this);
+            return true;
+        }
+
+        CHANNEL_RECEIVE_TYPE(T) await_resume()
+        {
+            if (this->m_error != std::errc{}) {
+                return receiveError<T>(this->m_error, "receive on closed channel");
+            }
+            return receiveSuccess(std::move(*this->m_value));
+        }
+
+    private:
+        void resume() override { m_executor(this->m_handle); }
+
+        std::shared_ptr<Channel<T>> m_channel;
+        Executor                    m_executor;
+    };
+
+    template <typename T, typename Executor>
+    class SendAwaiter : public AsyncSendWaiter<T>
+    {
+    public:
+        SendAwaiter(std::shared_ptr<Channel<T>> channel, T&& value, Executor executor)
+            : AsyncSendWaiter<T>{ std::move(value) }
+            , m_channel{ std::move(channel) }
+            , m_executor{ std::move(executor) }
+        {
+        }
+
+        SendAwaiter(const SendAwaiter&)            = delete;
+        SendAwaiter& operator=(const SendAwaiter&) = delete;
+
+        bool await_ready() const noexcept { return false; }
+
+        // returns false (not suspending) if the value could be sent right away
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            auto& channel = *m_channel;
+
+            auto lock = channel.lockFromSender();
+            if (channel.m_receivers.load() == 0) {
+                this->m_error = std::errc::broken_pipe;
+                return false;
+            }
+            if (!channel.full()) {
+                auto resumable = ResumeQueue{};
+                channel.push(std::move(this->m_value), resumable);
+                auto parked = channel.m_parked != 0;
+                lock.unlock();
+
+                if (parked) {
+                    channel.m_cv.notify_one();
+                }
+                resumable.resumeAll();
+                return false;
+            }
+
+            this->m_handle = handle;
+            channel.m_asyncSenders.push(*this);
+            return true;
+        }
+
+        CHANNEL_SEND_TYPE await_resume()
+        {
+            if (this->m_error != std::errc{}) {
+                return sendError(this->m_error, "send on closed channel");
+            }
+            return sendSuccess();
+        }
+
+    private:
+        void resume() override { m_executor(this->m_handle); }
+
+        std::shared_ptr<Channel<T>> m_channel;
+        Executor                    m_executor;
+    };
+}
+
+// capacity of 0 (the default) creates an unbounded channel, otherwise the channel holds at most capacity elements
+// and Sender::send blocks while it is full. see Channel for retainedSegments.
 template <std::move_constructible T>
-std::pair<Sender<T>, Receiver<T>> makeChannel()
+std::pair<Sender<T>, Receiver<T>> makeChannel(std::size_t capacity = 0, std::size_t retainedSegments = 0)
 {
-    auto channel = std::make_shared<Channel<T>>();
+    auto channel = std::make_shared<Channel<T>>(capacity, retainedSegments);
     return std::make_pair(Sender<T>{ channel }, Receiver<T>{ channel });
 }
 
@@ -0,0 +1,108 @@
+#include "channel.hpp"
+#include "mpmc_channel.hpp"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int s_messages   = 1 << 20;
+constexpr int s_capacity   = 1024;
+constexpr int s_roundTrips = 100'000;
+
+// numThreads producers and numThreads consumers moving s_messages ints in total, returns msg/s
+template <typename Tx, typename Rx>
+double contention(Tx tx, Rx rx, int numThreads)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < numThreads; ++i) {
+            auto count = s_messages / numThreads + (i < s_messages % numThreads ? 1 : 0);
+            threads.emplace_back([tx, count]() mutable {
+                for (int j = 0; j < count; ++j) {
+                    if (tx.send(int{ j })) {
+                        break;
+                    }
+                }
+            });
+        }
+        tx.close();
+
+        // Receiver is move-only, so all the consumers share the same one, its receive() is safe to call concurrently
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back([&rx] {
+                while (true) {
+                    auto [value, err] = rx.receive();
+                    if (err) {
+                        break;
+                    }
+                }
+            });
+        }
+    }
+    auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    return s_messages / duration.count();
+}
+
+// one message bounced back and forth between two threads over two channels, returns the mean round-trip time
+std::chrono::nanoseconds pingPong(WaitPolicy policy)
+{
+    auto [pingTx, pingRx] = makeChannel<int>();
+    auto [pongTx, pongRx] = makeChannel<int>();
+    pingRx.setWaitPolicy(policy);
+    pongRx.setWaitPolicy(policy);
+
+    std::jthread echo{ [rx = std::move(pingRx), tx = std::move(pongTx)]() mutable {
+        while (true) {
+            auto [value, err] = rx.receive();
+            if (err || tx.send(std::move(value))) {
+                break;
+            }
+        }
+    } };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < s_roundTrips; ++i) {
+        pingTx.send(int{ i });
+        pongRx.receive();
+    }
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    pingTx.close();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration) / s_roundTrips;
+}
+
+int main()
+{
+    std::cout << std::format("{} messages, capacity {}, msg/s by number of producers (and consumers)\n", s_messages, s_capacity);
+    std::cout << std::format("{:>8} {:>16} {:>16}\n", "threads", "Channel", "MpmcChannel");
+
+    for (int numThreads : { 1, 2, 4, 8, 16, 32 }) {
+        auto mutexRate = [&] {
+            auto [tx, rx] = makeChannel<int>(s_capacity);
+            return contention(std::move(tx), std::move(rx), numThreads);
+        }();
+
+        auto mpmcRate = [&] {
+            auto [tx, rx] = makeMpmcChannel<int>(s_capacity);
+            return contention(std::move(tx), std::move(rx), numThreads);
+        }();
+
+        std::cout << std::format("{:>8} {:>16} {:>16}\n", numThreads, mutexRate, mpmcRate);
+    }
+
+    std::cout << std::format("\n{} round trips between two threads, mean round-trip latency by wait policy\n", s_roundTrips);
+    std::cout << std::format("{:>8} {:>8} {:>16}\n", "spin", "yield", "latency");
+
+    for (auto policy : {
+             WaitPolicy{ .spinCount = 0, .yieldCount = 0 },
+             WaitPolicy{ .spinCount = 0, .yieldCount = 16 },
+             WaitPolicy{ .spinCount = 1'000, .yieldCount = 0 },
+             WaitPolicy{ .spinCount = 10'000, .yieldCount = 16 },
+         }) {
+        std::cout << std::format("{:>8} {:>8} {:>16}\n", policy.spinCount, policy.yieldCount, pingPong(policy));
+    }
+}
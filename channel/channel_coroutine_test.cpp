@@ -0,0 +1,113 @@
+#include "channel.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// fire-and-forget coroutine, starts eagerly and destroys itself at the end
+struct Detached
+{
+    struct promise_type
+    {
+        Detached            get_return_object() { return {}; }
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+        std::suspend_never  final_suspend() noexcept { return {}; }
+        void                return_void() { }
+        void                unhandled_exception() { std::terminate(); }
+    };
+};
+
+// a handful of threads resuming coroutines handed to them through a channel
+class ThreadExecutor
+{
+public:
+    ThreadExecutor(std::size_t numThreads)
+    {
+        auto [tx, rx] = makeChannel<std::coroutine_handle<>>();
+        m_sender      = std::move(tx);
+        m_receiver    = std::make_shared<Receiver<std::coroutine_handle<>>>(std::move(rx));
+
+        for (std::size_t i = 0; i < numThreads; ++i) {
+            m_threads.emplace_back([receiver = m_receiver] {
+                while (true) {
+                    auto [handle, err] = receiver->receive();
+                    if (err) {
+                        break;
+                    }
+                    handle.resume();
+                }
+            });
+        }
+    }
+
+    ~ThreadExecutor() { m_sender->close(); }
+
+    struct Ref
+    {
+        ThreadExecutor* m_executor;
+        void operator()(std::coroutine_handle<> handle) const { m_executor->m_sender->send(std::move(handle)); }
+    };
+
+    Ref ref() { return { this }; }
+
+private:
+    std::optional<Sender<std::coroutine_handle<>>>     m_sender;
+    std::shared_ptr<Receiver<std::coroutine_handle<>>> m_receiver;
+    std::vector<std::jthread>                          m_threads;
+};
+
+Detached consumer(Receiver<int>& rx, ThreadExecutor::Ref executor, std::atomic<long long>& sum, std::atomic<int>& done)
+{
+    while (true) {
+        auto [value, err] = co_await rx.async_receive(executor);
+        if (err) {
+            break;
+        }
+        sum += value;
+    }
+    ++done;
+}
+
+Detached producer(Sender<int> tx, int count)
+{
+    for (int i = 1; i <= count; ++i) {
+        // suspends (instead of blocking the thread) whenever the channel is full
+        if (auto err = co_await tx.async_send(int{ i }); err) {
+            std::cout << std::format("producer: {}\n", err.message());
+            break;
+        }
+    }
+}
+
+int main()
+{
+    constexpr int numConsumers = 1000;
+    constexpr int count        = 100'000;
+
+    std::atomic<long long> sum  = 0;
+    std::atomic<int>       done = 0;
+    {
+        ThreadExecutor executor{ 2 };
+
+        auto [tx, rx] = makeChannel<int>(64);
+
+        // a thousand logical consumers, none of them owns a thread
+        for (int i = 0; i < numConsumers; ++i) {
+            consumer(rx, executor.ref(), sum, done);
+        }
+
+        producer(std::move(tx), count);
+
+        while (done.load() != numConsumers) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::cout << std::format("sum: {} (expected {})\n", sum.load(), static_cast<long long>(count) * (count + 1) / 2);
+}
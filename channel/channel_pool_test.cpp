@@ -0,0 +1,66 @@
+#include "channel.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <new>
+#include <string>
+
+// count every heap allocation made by the program
+std::atomic<std::size_t> g_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (auto* pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    ++g_allocations;
+    auto align = static_cast<std::size_t>(alignment);
+    if (auto* pointer = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+// bursts of sends followed by as many receives, the queue keeps growing and shrinking
+std::size_t bursts(Sender<int>& tx, Receiver<int>& rx, int numBursts, int burstSize)
+{
+    auto before = g_allocations.load();
+    for (int i = 0; i < numBursts; ++i) {
+        for (int j = 0; j < burstSize; ++j) {
+            tx.send(int{ j });
+        }
+        for (int j = 0; j < burstSize; ++j) {
+            rx.receive();
+        }
+    }
+    return g_allocations.load() - before;
+}
+
+void run(const std::string& name, std::size_t retainedSegments)
+{
+    auto [tx, rx] = makeChannel<int>(0, retainedSegments);
+
+    bursts(tx, rx, 10, 10'000);    // warm up: let the queue reach its usual size
+    auto allocations = bursts(tx, rx, 1'000, 10'000);
+
+    std::cout << std::format("{}: {} allocations in steady state\n", name, allocations);
+}
+
+int main()
+{
+    run("std::deque segments", 0);
+    run("pooled segments", 128);
+}
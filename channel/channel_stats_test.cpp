@@ -0,0 +1,108 @@
+#define CHANNEL_STATS 1
+#include "channel.hpp"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+void print(const std::string& name, const ChannelStats& stats)
+{
+    std::cout << std::format(
+        "{}:\n"
+        "\tdepth            : {} (high-water {})\n"
+        "\tsent / received  : {} / {}\n"
+        "\treceiver wait    : {} us\n"
+        "\tsender lock wait : {} us\n"
+        "\tlock collisions  : {}\n",
+        name,
+        stats.depth,
+        stats.highWaterDepth,
+        stats.sent,
+        stats.received,
+        std::chrono::duration_cast<std::chrono::microseconds>(stats.receiverWaitTime).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(stats.senderLockWaitTime).count(),
+        stats.lockCollisions
+    );
+}
+
+// a slow consumer: the queue backs up and the high-water mark shows how far
+void slowConsumer()
+{
+    auto [tx, rx] = makeChannel<int>();
+
+    std::jthread consumer{ [rx = std::move(rx)]() mutable {
+        while (true) {
+            auto [value, err] = rx.receive();
+            if (err) {
+                break;
+            }
+            std::this_thread::sleep_for(10us);
+        }
+    } };
+
+    for (int i = 0; i < 1'000; ++i) {
+        tx.send(int{ i });
+    }
+    auto stats = tx.stats();
+    tx.close();
+    consumer.join();
+    print("slow consumer", stats);
+}
+
+// a starved consumer: the receiver spends its time waiting for elements
+void slowProducer()
+{
+    auto [tx, rx] = makeChannel<int>();
+
+    std::jthread consumer{ [rx = std::move(rx)]() mutable {
+        while (!rx.receive().second) { }
+    } };
+
+    for (int i = 0; i < 100; ++i) {
+        tx.send(int{ i });
+        std::this_thread::sleep_for(100us);
+    }
+
+    auto stats = tx.stats();
+    tx.close();
+    consumer.join();
+    print("slow producer", stats);
+}
+
+// many senders hammering one channel: the mutex becomes the bottleneck
+void contendedSenders()
+{
+    auto [tx, rx] = makeChannel<int>();
+
+    std::jthread consumer{ [rx = std::move(rx)]() mutable {
+        while (!rx.receive().second) { }
+    } };
+
+    {
+        std::vector<std::jthread> producers;
+        for (int i = 0; i < 8; ++i) {
+            producers.emplace_back([tx]() mutable {
+                for (int j = 0; j < 100'000; ++j) {
+                    tx.send(int{ j });
+                }
+            });
+        }
+    }
+
+    auto stats = tx.stats();
+    tx.close();
+    consumer.join();
+    print("contended senders", stats);
+}
+
+int main()
+{
+    slowConsumer();
+    slowProducer();
+    contendedSenders();
+}
@@ -2,12 +2,15 @@
 
 #include <format>
 #include <iostream>
+#include <numeric>
 #include <ranges>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace rv = std::views;
 
-int main()
+void unbounded()
 {
     using namespace std::chrono_literals;
 
@@ -47,3 +50,133 @@ int main()
         std::cout << std::format("received: {}\n", value);
     }
 }
+
+void bounded()
+{
+    using namespace std::chrono_literals;
+
+    auto [tx, rx] = makeChannel<int>(4);
+
+    std::jthread producer{ [tx = std::move(tx)]() mutable {
+        for (auto i : rv::iota(0, 20)) {
+            // send blocks once 4 elements are queued, so the producer runs at the consumer pace
+            auto err = tx.send(std::move(i));
+            if (err) {
+                break;
+            }
+            std::cout << std::format("sent: {}\n", i);
+        }
+
+        auto value = 42;
+        if (auto err = tx.try_send(std::move(value)); err) {
+            std::cout << std::format("try_send: {}\n", err.message());
+        }
+        if (auto err = tx.send_for(std::move(value), 50ms); err) {
+            std::cout << std::format("send_for: {}\n", err.message());
+        }
+        std::cout << "producer done\n";
+    } };
+
+    while (true) {
+        auto [value, err] = rx.receive();
+        if (err) {
+            std::cout << std::format("Error: {}\n", err.message());
+            break;
+        }
+        std::this_thread::sleep_for(100ms);
+        std::cout << std::format("received: {}\n", value);
+    }
+}
+
+void batch()
+{
+    using namespace std::chrono_literals;
+
+    auto [tx, rx] = makeChannel<int>(8);
+
+    std::jthread producer{ [tx = std::move(tx)]() mutable {
+        for (auto i : rv::iota(0, 5)) {
+            auto batch = std::vector<int>(6);
+            std::iota(batch.begin(), batch.end(), i * 6);
+
+            // the second batch onward blocks midway until the consumer makes room
+            if (auto err = tx.sendMany(batch); err) {
+                break;
+            }
+            std::this_thread::sleep_for(50ms);
+        }
+        std::cout << "producer done\n";
+    } };
+
+    auto buffer = std::vector<int>{};
+    while (true) {
+        buffer.clear();
+        auto [count, err] = rx.receiveMany(std::back_inserter(buffer), 4);
+        if (err) {
+            std::cout << std::format("Error: {}\n", err.message());
+            break;
+        }
+        std::cout << std::format("received {} elements starting from {}\n", count, buffer.front());
+        std::this_thread::sleep_for(100ms);
+
+        auto [rest, drainErr] = rx.drain();
+        std::cout << std::format("drained {} elements\n", rest.size());
+    }
+}
+
+void polling()
+{
+    using namespace std::chrono_literals;
+
+    auto [tx1, rx1] = makeChannel<int>();
+    auto [tx2, rx2] = makeChannel<int>();
+
+    std::jthread producer{ [tx1 = std::move(tx1), tx2 = std::move(tx2)]() mutable {
+        for (auto i : rv::iota(0, 5)) {
+            tx1.send(int{ i });
+            std::this_thread::sleep_for(30ms);
+            tx2.send(i * 100);
+            std::this_thread::sleep_for(70ms);
+        }
+        std::cout << "producer done\n";
+    } };
+
+    // one thread polls both channels without parking on either of them
+    auto open = 2;
+    while (open > 0) {
+        open = 0;
+        for (auto* rx : { &rx1, &rx2 }) {
+            auto [value, err] = rx->try_receive();
+            if (!err) {
+                std::cout << std::format("polled: {}\n", value);
+            }
+            if (err != std::errc::broken_pipe) {
+                ++open;
+            }
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+
+    auto [tx3, rx3] = makeChannel<int>();
+    if (auto [value, err] = rx3.receive_for(50ms); err) {
+        std::cout << std::format("receive_for: {}\n", err.message());
+    }
+
+    // a blocked receive still gets an element sent right before the last sender closed
+    auto [tx4, rx4] = makeChannel<int>();
+    std::jthread receiver{ [rx4 = std::move(rx4)]() mutable {
+        auto [value, err] = rx4.receive();
+        std::cout << std::format("receive across close: {}\n", err ? err.message() : std::to_string(value));
+    } };
+    std::this_thread::sleep_for(20ms);
+    tx4.send(42);
+    tx4.close();
+}
+
+int main()
+{
+    unbounded();
+    bounded();
+    batch();
+    polling();
+}
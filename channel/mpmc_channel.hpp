@@ -0,0 +1,440 @@
+#ifndef MPMC_CHANNEL_HPP_R4PNE8VX
+#define MPMC_CHANNEL_HPP_R4PNE8VX
+
+#include "channel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+template <std::move_constructible T>
+class MpmcSender;
+
+template <std::move_constructible T>
+class MpmcReceiver;
+
+template <std::move_constructible T>
+class MpmcReceiveSlot;
+
+// multi-producer multi-consumer bounded channel based on Dmitry Vyukov's bounded queue: every cell carries a sequence
+// number that tells whether it is ready to be written (seq == pos) or read (seq == pos + 1) at a given position, so
+// senders and receivers only contend on a CAS of their own position counter.
+//
+// blocking is done on two futex words: m_readable is bumped after a push and m_writable after a pop, but only when
+// somebody is registered as waiting on it (see wakeOne). closing the last sender (receiver) bumps m_readable (m_writable) to wake
+// everyone up.
+template <std::move_constructible T>
+struct MpmcChannel
+{
+    friend class MpmcSender<T>;
+    friend class MpmcReceiver<T>;
+    friend class MpmcReceiveSlot<T>;
+
+public:
+    // capacity is rounded up to the next power of two
+    explicit MpmcChannel(std::size_t capacity)
+        : m_mask{ std::bit_ceil(std::max(capacity, std::size_t{ 2 })) - 1 }
+        , m_cells{ std::make_unique<Cell[]>(m_mask + 1) }
+    {
+        for (std::size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcChannel()
+    {
+        auto pos = m_popPos.load(std::memory_order_relaxed);
+        auto end = m_pushPos.load(std::memory_order_relaxed);
+        for (; pos != end; ++pos) {
+            std::destroy_at(m_cells[pos & m_mask].value());
+        }
+    }
+
+    MpmcChannel(const MpmcChannel&)            = delete;
+    MpmcChannel& operator=(const MpmcChannel&) = delete;
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> m_sequence;
+        alignas(T) std::byte     m_data[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(m_data)); }
+    };
+
+    // reserves the cell at the next push position, returns nullptr if the channel is full.
+    // the cell must be constructed into then handed back to publish().
+    Cell* claimPush(std::size_t& pos)
+    {
+        pos = m_pushPos.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = m_cells[pos & m_mask];
+            auto  seq  = cell.m_sequence.load(std::memory_order_acquire);
+            auto  diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+            if (diff == 0) {
+                if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &cell;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = m_pushPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void publish(Cell& cell, std::size_t pos)
+    {
+        cell.m_sequence.store(pos + 1, std::memory_order_release);
+        wakeOne(m_readable, m_waitingReceivers);
+    }
+
+    // reserves the cell at the next pop position, returns nullptr if the channel is empty.
+    // the value must be moved out and destroyed then the cell handed back to release().
+    Cell* claimPop(std::size_t& pos)
+    {
+        pos = m_popPos.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = m_cells[pos & m_mask];
+            auto  seq  = cell.m_sequence.load(std::memory_order_acquire);
+            auto  diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &cell;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = m_popPos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void release(Cell& cell, std::size_t pos)
+    {
+        cell.m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+        wakeOne(m_writable, m_waitingSenders);
+    }
+
+    // a waiter registers itself in waiting before checking the channel one last time and sleeping on event. each
+    // registration is consumed by exactly one wake up, so a burst of pushes while a receiver is being scheduled only
+    // costs one notify. a registration left behind by a waiter that succeeded on its last check only costs a spurious
+    // notify later.
+    static void wakeOne(std::atomic<std::uint32_t>& event, std::atomic<std::uint32_t>& waiting)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto count = waiting.load(std::memory_order_relaxed);
+        while (count > 0) {
+            if (waiting.compare_exchange_weak(count, count - 1, std::memory_order_relaxed)) {
+                event.fetch_add(1, std::memory_order_release);
+                event.notify_one();
+                return;
+            }
+        }
+    }
+
+    const std::size_t        m_mask;
+    std::unique_ptr<Cell[]>  m_cells;
+    std::atomic<std::size_t> m_senders   = 0;
+    std::atomic<std::size_t> m_receivers = 0;
+
+    alignas(channel_detail::s_cacheLineSize) std::atomic<std::size_t> m_pushPos = 0;
+    alignas(channel_detail::s_cacheLineSize) std::atomic<std::size_t> m_popPos  = 0;
+
+    alignas(channel_detail::s_cacheLineSize) std::atomic<std::uint32_t> m_readable = 0;
+    std::atomic<std::uint32_t>                                          m_waitingReceivers = 0;
+
+    alignas(channel_detail::s_cacheLineSize) std::atomic<std::uint32_t> m_writable = 0;
+    std::atomic<std::uint32_t>                                          m_waitingSenders = 0;
+};
+
+template <std::move_constructible T>
+class MpmcSender
+{
+public:
+    MpmcSender(std::shared_ptr<MpmcChannel<T>> channel)
+        : m_channel{ std::move(channel) }
+    {
+        m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~MpmcSender() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            if (m_channel->m_senders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                m_channel->m_readable.fetch_add(1, std::memory_order_release);
+                m_channel->m_readable.notify_all();
+            }
+            m_channel.reset();
+        }
+    }
+
+    MpmcSender(const MpmcSender& other)
+        : m_channel{ other.m_channel }
+    {
+        m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MpmcSender<T>& operator=(const MpmcSender& other)
+    {
+        if (this != &other && m_channel != other.m_channel) {
+            close();
+            m_channel = other.m_channel;
+            m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    MpmcSender(MpmcSender&&)               = default;
+    MpmcSender<T>& operator=(MpmcSender&&) = default;
+
+    // blocks while the channel is full
+    CHANNEL_SEND_TYPE send(T&& value) { return emplaceImpl(true, std::move(value)); }
+
+    // never blocks; if the channel is full, value is left untouched
+    CHANNEL_SEND_TYPE try_send(T&& value) { return emplaceImpl(false, std::move(value)); }
+
+    // blocks while the channel is full, then constructs the element directly inside its cell.
+    // (there is no claim/commit here like SpscSender has: a claimed but never committed cell would stall every other
+    // sender and receiver behind it)
+    template <typename... Args>
+        requires std::constructible_from<T, Args...>
+    CHANNEL_SEND_TYPE emplace(Args&&... args)
+    {
+        return emplaceImpl(true, std::forward<Args>(args)...);
+    }
+
+private:
+    template <typename... Args>
+    CHANNEL_SEND_TYPE emplaceImpl(bool block, Args&&... args)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        auto pushInto = [&](auto& cell, std::size_t pos) {
+            std::construct_at(cell.value(), std::forward<Args>(args)...);
+            channel.publish(cell, pos);
+            return channel_detail::sendSuccess();
+        };
+
+        while (true) {
+            auto event = channel.m_writable.load(std::memory_order_acquire);
+
+            if (channel.m_receivers.load(std::memory_order_acquire) == 0) {
+                return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+            }
+
+            auto pos = std::size_t{};
+            if (auto* cell = channel.claimPush(pos)) {
+                return pushInto(*cell, pos);
+            }
+
+            if (!block) {
+                return channel_detail::sendError(std::errc::no_buffer_space, "send on full channel");
+            }
+
+            // register first, then check again so a pop racing with us either sees the registration or leaves
+            // space for the second attempt
+            channel.m_waitingSenders.fetch_add(1, std::memory_order_seq_cst);
+            if (auto* cell = channel.claimPush(pos)) {
+                return pushInto(*cell, pos);
+            }
+            if (channel.m_receivers.load(std::memory_order_acquire) != 0) {
+                channel.m_writable.wait(event, std::memory_order_acquire);
+            }
+        }
+    }
+
+    std::shared_ptr<MpmcChannel<T>> m_channel;
+};
+
+// unlike Receiver, MpmcReceiver is copyable: every copy competes for the same elements
+template <std::move_constructible T>
+class MpmcReceiver
+{
+public:
+    MpmcReceiver(std::shared_ptr<MpmcChannel<T>> channel)
+        : m_channel{ std::move(channel) }
+    {
+        m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~MpmcReceiver() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            if (m_channel->m_receivers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                m_channel->m_writable.fetch_add(1, std::memory_order_release);
+                m_channel->m_writable.notify_all();
+            }
+            m_channel.reset();
+        }
+    }
+
+    MpmcReceiver(const MpmcReceiver& other)
+        : m_channel{ other.m_channel }
+    {
+        m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MpmcReceiver<T>& operator=(const MpmcReceiver& other)
+    {
+        if (this != &other && m_channel != other.m_channel) {
+            close();
+            m_channel = other.m_channel;
+            m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    MpmcReceiver(MpmcReceiver&&)               = default;
+    MpmcReceiver<T>& operator=(MpmcReceiver&&) = default;
+
+    // blocks while the channel is empty; elements sent before the last sender closed are still received
+    CHANNEL_RECEIVE_TYPE(T) receive()
+    {
+        auto pos   = std::size_t{};
+        auto* cell = acquire(pos);
+        if (!cell) {
+            return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+        }
+
+        auto value = std::move(*cell->value());
+        std::destroy_at(cell->value());
+        m_channel->release(*cell, pos);
+        return channel_detail::receiveSuccess(std::move(value));
+    }
+
+    // blocks while the channel is empty, then gives access to the next element in place. the element is taken by
+    // this receiver either way; its cell goes back to the senders once the returned slot is released (or dropped).
+    CHANNEL_RECEIVE_TYPE(MpmcReceiveSlot<T>) peek()
+    {
+        auto pos   = std::size_t{};
+        auto* cell = acquire(pos);
+        if (!cell) {
+            return channel_detail::receiveError<MpmcReceiveSlot<T>>(std::errc::broken_pipe, "receive on closed channel");
+        }
+        return channel_detail::receiveSuccess(MpmcReceiveSlot<T>{ m_channel, cell, pos });
+    }
+
+private:
+    using Channel_type = MpmcChannel<T>;
+    using Cell_type    = Channel_type::Cell;
+
+    // blocks until a cell is claimed, returns nullptr once the channel is closed and empty
+    Cell_type* acquire(std::size_t& pos)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        while (true) {
+            auto event = channel.m_readable.load(std::memory_order_acquire);
+            auto open  = channel.m_senders.load(std::memory_order_acquire) != 0;
+
+            if (auto* cell = channel.claimPop(pos)) {
+                return cell;
+            }
+            if (!open) {
+                return nullptr;
+            }
+
+            // see MpmcSender::emplaceImpl
+            channel.m_waitingReceivers.fetch_add(1, std::memory_order_seq_cst);
+            if (auto* cell = channel.claimPop(pos)) {
+                return cell;
+            }
+            channel.m_readable.wait(event, std::memory_order_acquire);
+        }
+    }
+
+    std::shared_ptr<MpmcChannel<T>> m_channel;
+};
+
+// an element taken by MpmcReceiver::peek, still living in its cell
+template <std::move_constructible T>
+class MpmcReceiveSlot
+{
+public:
+    friend class MpmcReceiver<T>;
+
+    MpmcReceiveSlot() = default;
+
+    ~MpmcReceiveSlot() { release(); }
+
+    MpmcReceiveSlot(const MpmcReceiveSlot&)            = delete;
+    MpmcReceiveSlot& operator=(const MpmcReceiveSlot&) = delete;
+
+    MpmcReceiveSlot(MpmcReceiveSlot&& other) noexcept
+        : m_channel{ std::move(other.m_channel) }
+        , m_cell{ other.m_cell }
+        , m_pos{ other.m_pos }
+    {
+    }
+
+    MpmcReceiveSlot& operator=(MpmcReceiveSlot&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            m_channel = std::move(other.m_channel);
+            m_cell    = other.m_cell;
+            m_pos     = other.m_pos;
+        }
+        return *this;
+    }
+
+    T& operator*() const
+    {
+        assert(m_channel);
+        return *m_cell->value();
+    }
+
+    T* operator->() const { return &**this; }
+
+    // destroys the element and hands the cell back to the senders
+    void release()
+    {
+        if (m_channel) {
+            std::destroy_at(m_cell->value());
+            std::exchange(m_channel, nullptr)->release(*m_cell, m_pos);
+        }
+    }
+
+private:
+    using Cell_type = MpmcChannel<T>::Cell;
+
+    MpmcReceiveSlot(std::shared_ptr<MpmcChannel<T>> channel, Cell_type* cell, std::size_t pos)
+        : m_channel{ std::move(channel) }
+        , m_cell{ cell }
+        , m_pos{ pos }
+    {
+    }
+
+    std::shared_ptr<MpmcChannel<T>> m_channel;
+    Cell_type*                      m_cell = nullptr;
+    std::size_t                     m_pos  = 0;
+};
+
+// capacity is rounded up to the next power of two
+template <std::move_constructible T>
+std::pair<MpmcSender<T>, MpmcReceiver<T>> makeMpmcChannel(std::size_t capacity)
+{
+    auto channel = std::make_shared<MpmcChannel<T>>(capacity);
+    return std::make_pair(MpmcSender<T>{ channel }, MpmcReceiver<T>{ channel });
+}
+
+#endif /* end of include guard: MPMC_CHANNEL_HPP_R4PNE8VX */
@@ -0,0 +1,84 @@
+#include "mpmc_channel.hpp"
+
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    constexpr int numProducers = 4;
+    constexpr int numConsumers = 3;
+    constexpr int perProducer  = 1000;
+
+    auto [tx, rx] = makeMpmcChannel<int>(16);
+
+    std::mutex    mutex;
+    std::set<int> received;
+
+    std::vector<std::jthread> consumers;
+    for (int id = 0; id < numConsumers; ++id) {
+        consumers.emplace_back([rx, id, &mutex, &received]() mutable {
+            int count = 0;
+            while (true) {
+                auto [value, err] = rx.receive();
+                if (err) {
+                    std::cout << std::format("consumer {} done after {} elements: {}\n", id, count, err.message());
+                    break;
+                }
+                ++count;
+                std::unique_lock lock{ mutex };
+                received.insert(value);
+            }
+        });
+    }
+    rx.close();
+
+    std::vector<std::jthread> producers;
+    for (int id = 0; id < numProducers; ++id) {
+        producers.emplace_back([tx, id]() mutable {
+            for (int i = 0; i < perProducer; ++i) {
+                if (auto err = tx.send(id * perProducer + i); err) {
+                    std::cout << std::format("producer {}: {}\n", id, err.message());
+                    break;
+                }
+            }
+        });
+    }
+    tx.close();
+
+    producers.clear();
+    consumers.clear();
+
+    std::cout << std::format("received {} unique elements out of {}\n", received.size(), numProducers * perProducer);
+
+    // sending without any receiver left fails
+    auto [tx2, rx2] = makeMpmcChannel<int>(4);
+    rx2.close();
+    std::cout << std::format("send after receivers closed: {}\n", tx2.send(1).message());
+
+    // constructed in place and read in place
+    auto [tx3, rx3] = makeMpmcChannel<std::pair<int, std::string>>(4);
+    tx3.emplace(1, "one");
+    tx3.emplace(2, "two");
+    tx3.close();
+    while (true) {
+        auto [slot, err] = rx3.peek();
+        if (err) {
+            break;
+        }
+        std::cout << std::format("peeked: {} {}\n", slot->first, slot->second);
+    }
+
+    // the slot keeps the channel alive after the receiver that peeked it is gone
+    auto slot = [] {
+        auto [tx, rx] = makeMpmcChannel<std::string>(4);
+        tx.send("outlives its receiver");
+        return std::move(rx.peek().first);
+    }();
+    std::cout << std::format("peeked after close: {}\n", *slot);
+}
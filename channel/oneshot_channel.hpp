@@ -0,0 +1,239 @@
+#ifndef ONESHOT_CHANNEL_HPP_V2H6PC8L
+#define ONESHOT_CHANNEL_HPP_V2H6PC8L
+
+#include "channel.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+template <std::move_constructible T>
+class OneshotSender;
+
+template <std::move_constructible T>
+class OneshotReceiver;
+
+template <std::move_constructible T>
+std::pair<OneshotSender<T>, OneshotReceiver<T>> makeOneshot();
+
+namespace channel_detail
+{
+    // the only allocation of a oneshot channel: the value is stored inline and everything else is one state word.
+    // the sender and the receiver each set their detached bit when done, whoever comes second frees the state.
+    template <std::move_constructible T>
+    struct OneshotState
+    {
+        using State_type = std::uint32_t;    // 32-bit so atomic::wait maps directly to a futex
+
+        static constexpr State_type s_value            = 1 << 0;    // m_storage holds a value
+        static constexpr State_type s_senderClosed     = 1 << 1;    // no value will be sent
+        static constexpr State_type s_receiverWaiting  = 1 << 2;    // the receiver is (about to be) blocked in wait
+        static constexpr State_type s_taken            = 1 << 3;    // the receiver moved the value out
+        static constexpr State_type s_senderDetached   = 1 << 4;
+        static constexpr State_type s_receiverDetached = 1 << 5;
+
+        static constexpr State_type s_detached = s_senderDetached | s_receiverDetached;
+
+        T* value() { return std::launder(reinterpret_cast<T*>(m_storage)); }
+
+        // called by each side with its detached bit (plus anything to publish along with it)
+        void detach(State_type bits)
+        {
+            auto previous = m_state.fetch_or(bits, std::memory_order_acq_rel);
+            if (((previous | bits) & s_detached) == s_detached) {
+                if ((previous & (s_value | s_taken)) == s_value) {
+                    std::destroy_at(value());
+                }
+                delete this;
+            }
+        }
+
+        std::atomic<State_type> m_state = 0;
+        alignas(T) std::byte m_storage[sizeof(T)];
+    };
+}
+
+// sends at most one value; dropping it without sending makes the receiver fail with broken_pipe
+template <std::move_constructible T>
+class OneshotSender
+{
+public:
+    friend std::pair<OneshotSender<T>, OneshotReceiver<T>> makeOneshot<T>();
+
+    OneshotSender() = default;    // already closed, e.g. as the placeholder of a failed receive
+
+    ~OneshotSender() { close(); }
+
+    void close()
+    {
+        if (m_state) {
+            complete(State::s_senderClosed);
+        }
+    }
+
+    OneshotSender(const OneshotSender&)            = delete;
+    OneshotSender& operator=(const OneshotSender&) = delete;
+
+    OneshotSender(OneshotSender&& other) noexcept
+        : m_state{ std::exchange(other.m_state, nullptr) }
+    {
+    }
+
+    OneshotSender& operator=(OneshotSender&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            m_state = std::exchange(other.m_state, nullptr);
+        }
+        return *this;
+    }
+
+    // never blocks, the sender is closed afterwards. fails with broken_pipe if the receiver is already gone
+    CHANNEL_SEND_TYPE send(T&& value)
+    {
+        assert(m_state);
+        if ((m_state->m_state.load(std::memory_order_acquire) & State::s_receiverDetached) != 0) {
+            close();
+            return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+        }
+        std::construct_at(m_state->value(), std::move(value));
+        complete(State::s_value);
+        return channel_detail::sendSuccess();
+    }
+
+private:
+    using State = channel_detail::OneshotState<T>;
+
+    explicit OneshotSender(State* state)
+        : m_state{ state }
+    {
+    }
+
+    // publishes bits (value or closed) and detaches. if the receiver is parked it has to be notified before
+    // detaching since the receiver may free the state as soon as it sees the sender detached.
+    void complete(typename State::State_type bits)
+    {
+        auto* state   = std::exchange(m_state, nullptr);
+        auto  current = state->m_state.load(std::memory_order_relaxed);
+        while (true) {
+            auto waiting = (current & State::s_receiverWaiting) != 0;
+            auto desired = current | bits | (waiting ? 0 : State::s_senderDetached);
+            if (state->m_state.compare_exchange_weak(current, desired, std::memory_order_acq_rel)) {
+                if (!waiting) {
+                    if ((current & State::s_receiverDetached) != 0) {
+                        state->detach(0);    // we came second, this frees the state
+                    }
+                    return;
+                }
+                break;
+            }
+        }
+        state->m_state.notify_one();
+        state->detach(State::s_senderDetached);
+    }
+
+    State* m_state = nullptr;
+};
+
+template <std::move_constructible T>
+class OneshotReceiver
+{
+public:
+    friend std::pair<OneshotSender<T>, OneshotReceiver<T>> makeOneshot<T>();
+
+    OneshotReceiver() = default;    // already closed
+
+    ~OneshotReceiver() { close(); }
+
+    void close()
+    {
+        if (m_state) {
+            std::exchange(m_state, nullptr)->detach(State::s_receiverDetached);
+        }
+    }
+
+    OneshotReceiver(const OneshotReceiver&)            = delete;
+    OneshotReceiver& operator=(const OneshotReceiver&) = delete;
+
+    OneshotReceiver(OneshotReceiver&& other) noexcept
+        : m_state{ std::exchange(other.m_state, nullptr) }
+    {
+    }
+
+    OneshotReceiver& operator=(OneshotReceiver&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            m_state = std::exchange(other.m_state, nullptr);
+        }
+        return *this;
+    }
+
+    // blocks until the value is sent or the sender is dropped, the receiver is closed afterwards
+    CHANNEL_RECEIVE_TYPE(T) receive()
+    {
+        assert(m_state);
+        auto& word    = m_state->m_state;
+        auto  current = word.load(std::memory_order_acquire);
+
+        while ((current & (State::s_value | State::s_senderClosed)) == 0) {
+            if ((current & State::s_receiverWaiting) == 0) {
+                current = word.fetch_or(State::s_receiverWaiting, std::memory_order_acq_rel) | State::s_receiverWaiting;
+                continue;
+            }
+            word.wait(current, std::memory_order_acquire);
+            current = word.load(std::memory_order_acquire);
+        }
+        return take(current);
+    }
+
+    // never blocks; fails with resource_unavailable_try_again (and stays open) if the value is not there yet
+    CHANNEL_RECEIVE_TYPE(T) try_receive()
+    {
+        assert(m_state);
+        auto current = m_state->m_state.load(std::memory_order_acquire);
+        if ((current & (State::s_value | State::s_senderClosed)) == 0) {
+            return channel_detail::receiveError<T>(std::errc::resource_unavailable_try_again, "receive on empty channel");
+        }
+        return take(current);
+    }
+
+private:
+    using State = channel_detail::OneshotState<T>;
+
+    explicit OneshotReceiver(State* state)
+        : m_state{ state }
+    {
+    }
+
+    CHANNEL_RECEIVE_TYPE(T) take(typename State::State_type current)
+    {
+        auto* state = std::exchange(m_state, nullptr);
+        if ((current & State::s_value) == 0) {
+            state->detach(State::s_receiverDetached);
+            return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+        }
+
+        auto value = std::move(*state->value());
+        std::destroy_at(state->value());
+        state->detach(State::s_taken | State::s_receiverDetached);
+        return channel_detail::receiveSuccess(std::move(value));
+    }
+
+    State* m_state = nullptr;
+};
+
+// a channel for exactly one value, e.g. the result of a request handed to a worker. costs one allocation and no locks
+template <std::move_constructible T>
+std::pair<OneshotSender<T>, OneshotReceiver<T>> makeOneshot()
+{
+    auto* state = new channel_detail::OneshotState<T>{};
+    return { OneshotSender<T>{ state }, OneshotReceiver<T>{ state } };
+}
+
+#endif /* end of include guard: ONESHOT_CHANNEL_HPP_V2H6PC8L */
@@ -0,0 +1,101 @@
+#include "channel.hpp"
+#include "oneshot_channel.hpp"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+
+constexpr int s_requests = 200'000;
+
+template <typename Fn>
+void measure(const std::string& name, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << std::format("{}: {} ms ({} req/s)\n", name, duration.count(), s_requests / duration.count() * 1000);
+}
+
+// a worker squares numbers, each request carries the sender for its reply. Sender has no default constructor,
+// which receive needs to report errors, hence the optional
+template <typename ReplySender>
+struct Request
+{
+    int                        m_value;
+    std::optional<ReplySender> m_reply;
+};
+
+template <typename MakeReply>
+void requests(MakeReply makeReply)
+{
+    using ReplySender = decltype(makeReply().first);
+
+    auto [tx, rx] = makeChannel<Request<ReplySender>>();
+
+    std::jthread worker{ [rx = std::move(rx)]() mutable {
+        while (true) {
+            auto [request, err] = rx.receive();
+            if (err) {
+                break;
+            }
+            request.m_reply->send(request.m_value * request.m_value);
+        }
+    } };
+
+    long long sum = 0;
+    for (int i = 0; i < s_requests; ++i) {
+        auto [replyTx, replyRx] = makeReply();
+        tx.send({ i % 1000, std::move(replyTx) });
+        sum += replyRx.receive().first;
+    }
+    tx.close();
+    std::cout << std::format("sum: {}\n", sum);
+}
+
+// no thread switch involved, only the cost of the channel itself
+template <typename MakeReply>
+void roundTrips(MakeReply makeReply)
+{
+    long long sum = 0;
+    for (int i = 0; i < s_requests; ++i) {
+        auto [tx, rx] = makeReply();
+        tx.send(int{ i % 1000 });
+        sum += rx.receive().first;
+    }
+    std::cout << std::format("sum: {}\n", sum);
+}
+
+void dropped()
+{
+    {
+        auto [tx, rx] = makeOneshot<std::string>();
+        std::jthread worker{ [tx = std::move(tx)] { /* gives up without replying */ } };
+        auto [value, err] = rx.receive();
+        std::cout << std::format("sender dropped: {}\n", err.message());
+    }
+    {
+        auto [tx, rx] = makeOneshot<std::string>();
+        auto [value, err] = rx.try_receive();
+        std::cout << std::format("try_receive before send: {}\n", err.message());
+        rx.close();
+        std::cout << std::format("receiver dropped: {}\n", tx.send("too late").message());
+    }
+    {
+        auto [tx, rx] = makeOneshot<std::string>();
+        tx.send("ready before the receiver looked");
+        auto [value, err] = rx.receive();
+        std::cout << std::format("received: {}\n", value);
+    }
+}
+
+int main()
+{
+    dropped();
+    measure("create, send, receive with Channel", [] { roundTrips([] { return makeChannel<int>(); }); });
+    measure("create, send, receive with oneshot", [] { roundTrips([] { return makeOneshot<int>(); }); });
+    measure("reply over Channel", [] { requests([] { return makeChannel<int>(); }); });
+    measure("reply over oneshot", [] { requests([] { return makeOneshot<int>(); }); });
+}
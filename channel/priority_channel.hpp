@@ -0,0 +1,371 @@
+#ifndef PRIORITY_CHANNEL_HPP_J5D9WQ3M
+#define PRIORITY_CHANNEL_HPP_J5D9WQ3M
+
+#include "channel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Lanes FIFO queues, one per priority. a higher priority number is delivered first, elements of the same priority
+// keep their order. push and pop are O(1): a bitmask of the non-empty lanes finds the highest one.
+template <std::move_constructible T, std::size_t Lanes = 4>
+    requires(Lanes > 0 && Lanes <= 64)
+class PriorityLanes
+{
+public:
+    static constexpr std::size_t s_lanes = Lanes;
+
+    void push(T&& value, std::size_t priority)
+    {
+        assert(priority < Lanes);
+        m_lanes[priority].push_back(std::move(value));
+        m_nonEmpty |= std::uint64_t{ 1 } << priority;
+        ++m_size;
+    }
+
+    // must not be empty
+    T pop()
+    {
+        auto  priority = static_cast<std::size_t>(std::bit_width(m_nonEmpty) - 1);
+        auto& lane     = m_lanes[priority];
+        auto  value    = std::move(lane.front());
+        lane.pop_front();
+        if (lane.empty()) {
+            m_nonEmpty &= ~(std::uint64_t{ 1 } << priority);
+        }
+        --m_size;
+        return value;
+    }
+
+    std::size_t size() const { return m_size; }
+    bool        empty() const { return m_size == 0; }
+
+    // number of elements waiting in each lane
+    std::array<std::size_t, Lanes> depths() const
+    {
+        auto depths = std::array<std::size_t, Lanes>{};
+        std::ranges::transform(m_lanes, depths.begin(), [](const auto& lane) { return lane.size(); });
+        return depths;
+    }
+
+private:
+    std::array<std::deque<T>, Lanes> m_lanes;
+    std::uint64_t                    m_nonEmpty = 0;
+    std::size_t                      m_size     = 0;
+};
+
+// a binary heap ordered by Compare, the greatest element (as by std::priority_queue) is delivered first. elements
+// that compare equal keep their order. push and pop are O(log n).
+template <std::move_constructible T, typename Compare = std::less<T>>
+    requires std::strict_weak_order<Compare&, const T&, const T&>
+class PriorityHeap
+{
+public:
+    PriorityHeap() = default;
+
+    explicit PriorityHeap(Compare compare)
+        : m_compare{ std::move(compare) }
+    {
+    }
+
+    void push(T&& value)
+    {
+        m_heap.push_back({ std::move(value), m_sequence++ });
+        std::ranges::push_heap(m_heap, order());
+    }
+
+    // must not be empty
+    T pop()
+    {
+        std::ranges::pop_heap(m_heap, order());
+        auto value = std::move(m_heap.back().m_value);
+        m_heap.pop_back();
+        return value;
+    }
+
+    std::size_t size() const { return m_heap.size(); }
+    bool        empty() const { return m_heap.empty(); }
+
+private:
+    struct Entry
+    {
+        T             m_value;
+        std::uint64_t m_sequence;
+    };
+
+    // lower priority first, and among equals the later one first, so the heap top is the earliest of the greatest
+    auto order()
+    {
+        return [this](const Entry& lhs, const Entry& rhs) {
+            if (m_compare(lhs.m_value, rhs.m_value)) {
+                return true;
+            }
+            if (m_compare(rhs.m_value, lhs.m_value)) {
+                return false;
+            }
+            return lhs.m_sequence > rhs.m_sequence;
+        };
+    }
+
+    std::vector<Entry> m_heap;
+    Compare            m_compare;
+    std::uint64_t      m_sequence = 0;
+};
+
+// a queue with an explicit priority per element, below s_lanes (PriorityLanes), or one that orders the elements
+// themselves (PriorityHeap)
+template <typename Q, typename T>
+concept LanedPriorityQueue = requires(Q& queue, T&& value, std::size_t priority) {
+    queue.push(std::move(value), priority);
+    { Q::s_lanes } -> std::convertible_to<std::size_t>;
+};
+
+template <typename Q, typename T>
+concept OrderedPriorityQueue = requires(Q& queue, T&& value) { queue.push(std::move(value)); };
+
+template <std::move_constructible T, typename Queue>
+class PrioritySender;
+
+template <std::move_constructible T, typename Queue>
+class PriorityReceiver;
+
+// like Channel (unbounded, same close semantics) but receivers always get the highest priority element queued, so a
+// control message does not wait behind the data already queued. Queue is PriorityLanes for a small fixed number of
+// priorities or PriorityHeap to order the elements with a comparator.
+template <std::move_constructible T, typename Queue = PriorityLanes<T>>
+struct PriorityChannel
+{
+    friend class PrioritySender<T, Queue>;
+    friend class PriorityReceiver<T, Queue>;
+
+public:
+    explicit PriorityChannel(Queue queue = {})
+        : m_queue{ std::move(queue) }
+    {
+    }
+
+private:
+    Queue                    m_queue;
+    std::mutex               m_mutex;
+    std::condition_variable  m_cv;    // notified when an element is pushed or the last sender closed
+    std::atomic<std::size_t> m_senders   = 0;
+    std::atomic<std::size_t> m_receivers = 0;
+};
+
+template <std::move_constructible T, typename Queue>
+class PrioritySender
+{
+public:
+    using Channel_type = PriorityChannel<T, Queue>;
+
+    PrioritySender(std::shared_ptr<Channel_type> channel)
+        : m_channel{ std::move(channel) }
+    {
+        m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~PrioritySender() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            if (m_channel->m_senders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::unique_lock lock{ m_channel->m_mutex };
+                m_channel->m_cv.notify_all();
+            }
+            m_channel.reset();
+        }
+    }
+
+    PrioritySender(const PrioritySender& other)
+        : m_channel{ other.m_channel }
+    {
+        m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    PrioritySender& operator=(const PrioritySender& other)
+    {
+        if (this != &other && m_channel != other.m_channel) {
+            close();
+            m_channel = other.m_channel;
+            m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    PrioritySender(PrioritySender&&)            = default;
+    PrioritySender& operator=(PrioritySender&&) = default;
+
+    // never blocks. fails with invalid_argument if priority is not below the number of lanes
+    CHANNEL_SEND_TYPE send(T&& value, std::size_t priority)
+        requires LanedPriorityQueue<Queue, T>
+    {
+        if (priority >= Queue::s_lanes) {
+            return channel_detail::sendError(std::errc::invalid_argument, "send with a priority out of range");
+        }
+        return push([&](Queue& queue) { queue.push(std::move(value), priority); });
+    }
+
+    // never blocks
+    CHANNEL_SEND_TYPE send(T&& value)
+        requires OrderedPriorityQueue<Queue, T>
+    {
+        return push([&](Queue& queue) { queue.push(std::move(value)); });
+    }
+
+private:
+    template <typename Push>
+    CHANNEL_SEND_TYPE push(Push&& push)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+        {
+            std::unique_lock lock{ channel.m_mutex };
+            if (channel.m_receivers.load() == 0) {
+                return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+            }
+            push(channel.m_queue);
+        }
+        channel.m_cv.notify_one();
+        return channel_detail::sendSuccess();
+    }
+
+    std::shared_ptr<Channel_type> m_channel;
+};
+
+template <std::move_constructible T, typename Queue>
+class PriorityReceiver
+{
+public:
+    using Channel_type = PriorityChannel<T, Queue>;
+
+    PriorityReceiver(std::shared_ptr<Channel_type> channel)
+        : m_channel{ std::move(channel) }
+    {
+        m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~PriorityReceiver() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            m_channel->m_receivers.fetch_sub(1, std::memory_order_acq_rel);
+            m_channel.reset();
+        }
+    }
+
+    PriorityReceiver(const PriorityReceiver&)            = delete;
+    PriorityReceiver& operator=(const PriorityReceiver&) = delete;
+
+    PriorityReceiver(PriorityReceiver&&)            = default;
+    PriorityReceiver& operator=(PriorityReceiver&&) = default;
+
+    // blocks while the channel is empty; elements sent before the senders closed are still received
+    CHANNEL_RECEIVE_TYPE(T) receive()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        std::unique_lock lock{ channel.m_mutex };
+        channel.m_cv.wait(lock, [&] { return !channel.m_queue.empty() || channel.m_senders.load() == 0; });
+
+        if (channel.m_queue.empty()) {
+            return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+        }
+        return channel_detail::receiveSuccess(channel.m_queue.pop());
+    }
+
+    // never blocks
+    CHANNEL_RECEIVE_TYPE(T) try_receive()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        std::unique_lock lock{ channel.m_mutex };
+        if (channel.m_queue.empty()) {
+            if (channel.m_senders.load() == 0) {
+                return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+            }
+            return channel_detail::receiveError<T>(std::errc::resource_unavailable_try_again, "receive on empty channel");
+        }
+        return channel_detail::receiveSuccess(channel.m_queue.pop());
+    }
+
+    template <typename Clock, typename Duration>
+    CHANNEL_RECEIVE_TYPE(T) receive_until(const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        std::unique_lock lock{ channel.m_mutex };
+        auto ready = channel.m_cv.wait_until(lock, deadline, [&] {
+            return !channel.m_queue.empty() || channel.m_senders.load() == 0;
+        });
+
+        if (!ready) {
+            return channel_detail::receiveError<T>(std::errc::timed_out, "receive timed out");
+        }
+        if (channel.m_queue.empty()) {
+            return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+        }
+        return channel_detail::receiveSuccess(channel.m_queue.pop());
+    }
+
+    template <typename Rep, typename Period>
+    CHANNEL_RECEIVE_TYPE(T) receive_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return receive_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // blocks until at least one element is available, then moves up to maxCount elements into out, highest priority
+    // first, under a single lock. returns the number of elements received.
+    template <std::output_iterator<T> Out>
+    CHANNEL_RECEIVE_TYPE(std::size_t) receiveMany(Out out, std::size_t maxCount)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        std::unique_lock lock{ channel.m_mutex };
+        channel.m_cv.wait(lock, [&] { return !channel.m_queue.empty() || channel.m_senders.load() == 0; });
+
+        if (channel.m_queue.empty()) {
+            return channel_detail::receiveError<std::size_t>(std::errc::broken_pipe, "receive on closed channel");
+        }
+
+        auto count = std::min(maxCount, channel.m_queue.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            *out++ = channel.m_queue.pop();
+        }
+        return channel_detail::receiveSuccess(std::size_t{ count });
+    }
+
+private:
+    std::shared_ptr<Channel_type> m_channel;
+};
+
+// see PriorityChannel, e.g. makePriorityChannel<Message, PriorityLanes<Message, 3>>() or
+// makePriorityChannel<Job, PriorityHeap<Job, ByDeadline>>()
+template <std::move_constructible T, typename Queue = PriorityLanes<T>>
+std::pair<PrioritySender<T, Queue>, PriorityReceiver<T, Queue>> makePriorityChannel(Queue queue = {})
+{
+    auto channel = std::make_shared<PriorityChannel<T, Queue>>(std::move(queue));
+    return std::make_pair(PrioritySender<T, Queue>{ channel }, PriorityReceiver<T, Queue>{ channel });
+}
+
+#endif /* end of include guard: PRIORITY_CHANNEL_HPP_J5D9WQ3M */
@@ -0,0 +1,132 @@
+#include "priority_channel.hpp"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+struct Data
+{
+    int m_id;
+};
+
+struct Shutdown
+{
+};
+
+using Message = std::variant<Data, Shutdown>;
+
+enum Priority : std::size_t
+{
+    Bulk    = 0,
+    Normal  = 1,
+    Control = 2,
+};
+
+// the shutdown is sent after a backlog of data but handled first
+void controlFirst()
+{
+    auto [tx, rx] = makePriorityChannel<Message, PriorityLanes<Message, 3>>();
+
+    for (int i = 0; i < 10'000; ++i) {
+        tx.send(Data{ i }, i % 2 == 0 ? Bulk : Normal);
+    }
+    tx.send(Shutdown{}, Control);
+
+    auto handled = 0;
+    while (true) {
+        auto [message, err] = rx.receive();
+        if (err || std::holds_alternative<Shutdown>(message)) {
+            break;
+        }
+        ++handled;
+    }
+    std::cout << std::format("shutdown handled after {} data messages\n", handled);
+}
+
+// batch receive drains the higher lanes first, each lane in FIFO order
+void batches()
+{
+    auto [tx, rx] = makePriorityChannel<int, PriorityLanes<int, 3>>();
+
+    std::jthread producer{ [tx = std::move(tx)]() mutable {
+        for (int i = 0; i < 9; ++i) {
+            tx.send(int{ i }, static_cast<std::size_t>(i % 3));
+        }
+    } };
+    producer.join();
+
+    while (true) {
+        auto batch = std::vector<int>{};
+        auto [count, err] = rx.receiveMany(std::back_inserter(batch), 4);
+        if (err) {
+            std::cout << std::format("then: {}\n", err.message());
+            break;
+        }
+        std::cout << "batch:";
+        for (auto value : batch) {
+            std::cout << ' ' << value;
+        }
+        std::cout << '\n';
+    }
+}
+
+struct Job
+{
+    std::string                           m_name;
+    std::chrono::steady_clock::time_point m_deadline;
+};
+
+// earliest deadline first: "less" means a later deadline
+struct ByDeadline
+{
+    bool operator()(const Job& lhs, const Job& rhs) const { return lhs.m_deadline > rhs.m_deadline; }
+};
+
+void heap()
+{
+    auto [tx, rx] = makePriorityChannel<Job, PriorityHeap<Job, ByDeadline>>();
+
+    auto now = std::chrono::steady_clock::now();
+    tx.send(Job{ "report", now + 10s });
+    tx.send(Job{ "heartbeat", now + 1s });
+    tx.send(Job{ "backup", now + 1h });
+    tx.send(Job{ "reply", now + 1s });
+    tx.close();
+
+    std::cout << "by deadline:";
+    while (true) {
+        auto [job, err] = rx.try_receive();
+        if (err) {
+            break;
+        }
+        std::cout << ' ' << job.m_name;
+    }
+    std::cout << '\n';
+}
+
+void closeSemantics()
+{
+    auto [tx, rx] = makePriorityChannel<int>();
+
+    auto [value, err] = rx.receive_for(10ms);
+    std::cout << std::format("receive_for on empty channel: {}\n", err.message());
+
+    std::cout << std::format("send with priority 4 of 4 lanes: {}\n", tx.send(1, 4).message());
+
+    rx.close();
+    std::cout << std::format("send after receiver closed: {}\n", tx.send(1, 0).message());
+}
+
+int main()
+{
+    controlFirst();
+    batches();
+    heap();
+    closeSemantics();
+}
@@ -0,0 +1,210 @@
+#ifndef SELECT_HPP_M2XHD6TQ
+#define SELECT_HPP_M2XHD6TQ
+
+#include "channel.hpp"
+
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// waits on several Receiver at once (the types may differ) and dispatches to the handler of the first one that is
+// ready, like Go's select statement:
+//
+//     auto index = select(
+//         onReceive(rxInt, [](CHANNEL_RECEIVE_TYPE(int) result) { ... }),
+//         onReceive(rxString, [](CHANNEL_RECEIVE_TYPE(std::string) result) { ... }),
+//         onDefault([] { ... })    // optional, makes select non-blocking
+//     );
+//
+// a closed and empty channel is always ready, its handler receives the broken_pipe error (in CHANNEL_THROW mode the
+// error is thrown from select instead). the return value is the index of the case that ran. a loop selecting until
+// every channel is closed should drop a case once it reported closed, or it spins on that case's error; this is what
+// Go's idiom of setting such a channel to nil does.
+//
+// the cases are polled starting from a different one on every call so a channel that is always ready won't starve
+// the others.
+
+namespace channel_detail
+{
+    template <typename T, typename Handler>
+    class ReceiveCase
+    {
+    public:
+        ReceiveCase(Receiver<T>& receiver, Handler handler)
+            : m_receiver{ receiver }
+            , m_handler{ std::move(handler) }
+        {
+        }
+
+        bool poll() { return m_receiver.poll(m_handler); }
+        void attach(SelectWaiter& waiter) { m_receiver.addSelector(waiter); }
+        void detach(SelectWaiter& waiter) { m_receiver.removeSelector(waiter); }
+
+    private:
+        Receiver<T>& m_receiver;
+        Handler      m_handler;
+    };
+
+    template <typename Handler>
+    class DefaultCase
+    {
+    public:
+        DefaultCase(Handler handler)
+            : m_handler{ std::move(handler) }
+        {
+        }
+
+        bool poll() { return false; }
+        void attach(SelectWaiter&) { }
+        void detach(SelectWaiter&) { }
+
+        void operator()() { m_handler(); }
+
+    private:
+        Handler m_handler;
+    };
+
+    template <typename>
+    struct IsDefaultCase : std::false_type
+    {
+    };
+
+    template <typename Handler>
+    struct IsDefaultCase<DefaultCase<Handler>> : std::true_type
+    {
+    };
+
+    template <typename... Cases>
+    inline constexpr std::size_t defaultCaseCount = (std::size_t{ IsDefaultCase<Cases>::value } + ... + 0);
+
+    template <typename... Cases>
+    constexpr std::size_t defaultCaseIndex()
+    {
+        auto index = std::size_t{ 0 };
+        auto found = false;
+        ((found = found || IsDefaultCase<Cases>::value, index += found ? 0 : 1), ...);
+        return index;
+    }
+
+    // nullopt deadline means wait forever
+    template <typename Clock, typename Duration, typename... Cases>
+    std::optional<std::size_t> select(
+        const std::optional<std::chrono::time_point<Clock, Duration>>& deadline,
+        std::tuple<Cases...>&                                          cases
+    )
+    {
+        static_assert(sizeof...(Cases) > 0, "select needs at least one case");
+        static_assert(defaultCaseCount<Cases...> <= 1, "select can only have one default case");
+
+        constexpr auto count = sizeof...(Cases);
+
+        // poll the case at index, the index is only known at runtime
+        auto pollAt = [&]<std::size_t... Is>(std::size_t index, std::index_sequence<Is...>) {
+            auto ready = false;
+            ((Is == index ? (ready = std::get<Is>(cases).poll()) : false), ...);
+            return ready;
+        };
+
+        // fairness: every call on this thread starts from the next case
+        thread_local std::size_t s_offset = 0;
+        auto                     offset   = s_offset++;
+
+        auto pollAll = [&]() -> std::optional<std::size_t> {
+            for (std::size_t i = 0; i < count; ++i) {
+                auto index = (offset + i) % count;
+                if (pollAt(index, std::index_sequence_for<Cases...>{})) {
+                    return index;
+                }
+            }
+            return std::nullopt;
+        };
+
+        if constexpr (defaultCaseCount<Cases...> == 1) {
+            if (auto index = pollAll(); index) {
+                return index;
+            }
+            constexpr auto index = defaultCaseIndex<Cases...>();
+            std::get<index>(cases)();
+            return index;
+        } else {
+            SelectWaiter waiter;
+
+            std::apply([&](auto&... c) { (c.attach(waiter), ...); }, cases);
+            struct Detach
+            {
+                std::tuple<Cases...>& m_cases;
+                SelectWaiter&         m_waiter;
+
+                ~Detach()
+                {
+                    std::apply([&](auto&... c) { (c.detach(m_waiter), ...); }, m_cases);
+                }
+            } detach{ cases, waiter };
+
+            while (true) {
+                auto signal = std::uint64_t{};
+                {
+                    std::unique_lock lock{ waiter.m_mutex };
+                    signal = waiter.m_signal;
+                }
+
+                if (auto index = pollAll(); index) {
+                    return index;
+                }
+
+                std::unique_lock lock{ waiter.m_mutex };
+                auto             changed = [&] { return waiter.m_signal != signal; };
+                if (deadline) {
+                    if (!waiter.m_cv.wait_until(lock, *deadline, changed)) {
+                        return std::nullopt;
+                    }
+                } else {
+                    waiter.m_cv.wait(lock, changed);
+                }
+            }
+        }
+    }
+}
+
+template <std::move_constructible T, typename Handler>
+    requires std::invocable<Handler&, CHANNEL_RECEIVE_TYPE(T)>
+channel_detail::ReceiveCase<T, std::decay_t<Handler>> onReceive(Receiver<T>& receiver, Handler&& handler)
+{
+    return { receiver, std::forward<Handler>(handler) };
+}
+
+template <std::invocable Handler>
+channel_detail::DefaultCase<std::decay_t<Handler>> onDefault(Handler&& handler)
+{
+    return { std::forward<Handler>(handler) };
+}
+
+// blocks until one of the cases is ready (or runs the default case)
+template <typename... Cases>
+std::size_t select(Cases... cases)
+{
+    auto tuple = std::tuple<Cases...>{ std::move(cases)... };
+    return *channel_detail::select(std::optional<std::chrono::steady_clock::time_point>{}, tuple);
+}
+
+// returns nullopt if none of the cases got ready before deadline
+template <typename Clock, typename Duration, typename... Cases>
+std::optional<std::size_t> select_until(const std::chrono::time_point<Clock, Duration>& deadline, Cases... cases)
+{
+    auto tuple = std::tuple<Cases...>{ std::move(cases)... };
+    return channel_detail::select(std::optional{ deadline }, tuple);
+}
+
+template <typename Rep, typename Period, typename... Cases>
+std::optional<std::size_t> select_for(const std::chrono::duration<Rep, Period>& timeout, Cases... cases)
+{
+    return select_until(std::chrono::steady_clock::now() + timeout, std::move(cases)...);
+}
+
+#endif /* end of include guard: SELECT_HPP_M2XHD6TQ */
@@ -0,0 +1,77 @@
+#include "select.hpp"
+
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    auto [txInt, rxInt]       = makeChannel<int>();
+    auto [txString, rxString] = makeChannel<std::string>();
+
+    // nothing is sent yet, the default case runs
+    auto index = select(
+        onReceive(rxInt, [](auto) { std::cout << "unexpected int\n"; }),
+        onDefault([] { std::cout << "default: nothing ready yet\n"; })
+    );
+    std::cout << std::format("selected case {}\n", index);
+
+    std::jthread producer1{ [tx = std::move(txInt)]() mutable {
+        for (int i = 0; i < 5; ++i) {
+            tx.send(int{ i });
+            std::this_thread::sleep_for(70ms);
+        }
+        std::cout << "producer1 done\n";
+    } };
+
+    std::jthread producer2{ [tx = std::move(txString)]() mutable {
+        for (int i = 0; i < 3; ++i) {
+            tx.send(std::format("message {}", i));
+            std::this_thread::sleep_for(110ms);
+        }
+        std::cout << "producer2 done\n";
+    } };
+
+    auto intOpen    = true;
+    auto stringOpen = true;
+
+    auto onInt = [&](CHANNEL_RECEIVE_TYPE(int) result) {
+        auto [value, err] = result;
+        if (err) {
+            intOpen = false;
+            return;
+        }
+        std::cout << std::format("int: {}\n", value);
+    };
+    auto onString = [&](CHANNEL_RECEIVE_TYPE(std::string) result) {
+        auto [value, err] = std::move(result);
+        if (err) {
+            stringOpen = false;
+            return;
+        }
+        std::cout << std::format("string: {}\n", value);
+    };
+
+    // a closed channel is always ready, so a case is left out once it reported closed, otherwise the loop would spin
+    // on its error (Go does the same by setting the channel to nil)
+    while (intOpen || stringOpen) {
+        auto selected = std::optional<std::size_t>{};
+        if (intOpen && stringOpen) {
+            selected = select_for(500ms, onReceive(rxInt, onInt), onReceive(rxString, onString));
+        } else if (intOpen) {
+            selected = select_for(500ms, onReceive(rxInt, onInt));
+        } else {
+            selected = select_for(500ms, onReceive(rxString, onString));
+        }
+
+        if (!selected) {
+            std::cout << "timed out\n";
+        }
+    }
+
+    std::cout << "all channels closed\n";
+}
@@ -0,0 +1,459 @@
+#ifndef SHM_CHANNEL_HPP_R4N8XT2C
+#define SHM_CHANNEL_HPP_R4N8XT2C
+
+#include "channel.hpp"
+
+#if not defined(__linux__)
+#    error "ShmChannel needs linux (memfd, futex)"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+template <typename T>
+concept ShmTransferable = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>;
+
+template <ShmTransferable T>
+class ShmSender;
+
+template <ShmTransferable T>
+class ShmReceiver;
+
+namespace shm_channel_detail
+{
+    using Index_type = std::uint32_t;
+
+    static_assert(std::atomic<Index_type>::is_always_lock_free && sizeof(std::atomic<Index_type>) == sizeof(Index_type));
+
+    inline constexpr std::uint64_t s_magic       = 0x4c4e4e4148434d53;    // "SMCHANNL"
+    inline constexpr Index_type    s_closedBit   = Index_type{ 1 } << 31;
+    inline constexpr Index_type    s_indexMask   = s_closedBit - 1;
+    inline constexpr std::size_t   s_maxCapacity = std::size_t{ 1 } << 30;
+
+    [[noreturn]] inline void throwErrno(const char* what)
+    {
+        throw std::system_error{ errno, std::system_category(), what };
+    }
+
+    // std::atomic::wait uses process-private futexes, which do not wake up anything in another process even when
+    // the word is in shared memory, so the futex syscall is used directly
+    inline void futexWait(std::atomic<Index_type>& word, Index_type expected)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<Index_type*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+    }
+
+    inline void futexWake(std::atomic<Index_type>& word, int count)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<Index_type*>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+    }
+
+    inline Index_type distance(Index_type from, Index_type to) { return (to - from) & s_indexMask; }
+
+    // placed at the start of the shared region, the ring slots follow at Header::slotsOffset(alignof(T))
+    struct Header
+    {
+        std::atomic<std::uint64_t> m_magic;    // written last by the creator
+        std::uint32_t              m_elementSize;
+        std::uint32_t              m_elementAlign;
+        Index_type                 m_capacity;
+        std::atomic<Index_type>    m_receiverClosed;    // read by every send, the closed bit in m_head is for waking
+
+        // receiver side
+        alignas(channel_detail::s_cacheLineSize) std::atomic<Index_type> m_head;
+        std::atomic<Index_type> m_receiverParked;
+
+        // sender side
+        alignas(channel_detail::s_cacheLineSize) std::atomic<Index_type> m_tail;
+        std::atomic<Index_type> m_senderParked;
+
+        static std::size_t slotsOffset(std::size_t align)
+        {
+            align = std::max(align, channel_detail::s_cacheLineSize);
+            return (sizeof(Header) + align - 1) / align * align;
+        }
+    };
+}
+
+// single-producer single-consumer channel for trivially copyable types that lives in a shared memory region, so the
+// sender and receiver can be in different processes and elements are copied straight into the other process' memory
+// instead of going through a socket or pipe.
+//
+// the ring works like SpscChannel, except that the indices and parked flags live in the region and parking uses
+// shared futexes. the region is either an anonymous memfd, whose fd() is handed to the other process (inherited over
+// fork, or passed with SCM_RIGHTS) and mapped there with open(fd), or a named shm_open object opened by name.
+//
+// there is no reference counting across processes: one ShmSender and one ShmReceiver should be attached at a time,
+// each in the process that uses it (not both in the parent before a fork). the channel is closed for good once either
+// of them closes; until then a receiver that attaches before the sender simply waits for elements. a process dying
+// without closing its end leaves the peer waiting.
+template <ShmTransferable T>
+class ShmChannel
+{
+    friend class ShmSender<T>;
+    friend class ShmReceiver<T>;
+
+public:
+    using Index_type = shm_channel_detail::Index_type;
+
+    // creates a channel backed by an anonymous memfd. capacity is rounded up to the next power of two
+    static std::shared_ptr<ShmChannel> create(std::size_t capacity)
+    {
+        auto fd = ::memfd_create("channel", MFD_CLOEXEC);
+        if (fd < 0) {
+            shm_channel_detail::throwErrno("memfd_create");
+        }
+        return initialize(fd, capacity);
+    }
+
+    // creates a channel backed by the shm_open object name, which must not exist yet. call unlink once every process
+    // that needs it has opened it.
+    static std::shared_ptr<ShmChannel> create(const std::string& name, std::size_t capacity)
+    {
+        auto fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            shm_channel_detail::throwErrno("shm_open");
+        }
+        return initialize(fd, capacity);
+    }
+
+    // maps a channel created by another process; fd is duplicated, so the caller keeps ownership of its copy
+    static std::shared_ptr<ShmChannel> open(int fd)
+    {
+        auto dup = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (dup < 0) {
+            shm_channel_detail::throwErrno("fcntl");
+        }
+        return map(dup);
+    }
+
+    static std::shared_ptr<ShmChannel> open(const std::string& name)
+    {
+        auto fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) {
+            shm_channel_detail::throwErrno("shm_open");
+        }
+        return map(fd);
+    }
+
+    static void unlink(const std::string& name) { ::shm_unlink(name.c_str()); }
+
+    ~ShmChannel()
+    {
+        ::munmap(m_base, m_size);
+        ::close(m_fd);
+    }
+
+    ShmChannel(const ShmChannel&)            = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    int         fd() const { return m_fd; }
+    std::size_t capacity() const { return m_header->m_capacity; }
+
+private:
+    using Header = shm_channel_detail::Header;
+
+    struct Slot
+    {
+        alignas(T) std::byte m_data[sizeof(T)];
+    };
+
+    ShmChannel(int fd, void* base, std::size_t size)
+        : m_fd{ fd }
+        , m_base{ base }
+        , m_size{ size }
+        , m_header{ static_cast<Header*>(base) }
+        , m_slots{ reinterpret_cast<Slot*>(static_cast<std::byte*>(base) + Header::slotsOffset(alignof(T))) }
+    {
+    }
+
+    static std::size_t regionSize(std::size_t capacity)
+    {
+        return Header::slotsOffset(alignof(T)) + capacity * sizeof(Slot);
+    }
+
+    static std::shared_ptr<ShmChannel> initialize(int fd, std::size_t capacity)
+    {
+        assert(capacity <= shm_channel_detail::s_maxCapacity);
+        capacity = std::bit_ceil(std::max(capacity, std::size_t{ 1 }));
+
+        auto size = regionSize(capacity);
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            auto err = errno;
+            ::close(fd);
+            throw std::system_error{ err, std::system_category(), "ftruncate" };
+        }
+        auto channel = map(fd, size);
+
+        auto* header           = ::new (channel->m_base) Header{};
+        header->m_elementSize  = sizeof(T);
+        header->m_elementAlign = alignof(T);
+        header->m_capacity     = static_cast<Index_type>(capacity);
+        header->m_magic.store(shm_channel_detail::s_magic, std::memory_order_release);
+
+        return channel;
+    }
+
+    // takes ownership of fd. size 0 means the region is an existing channel which is validated
+    static std::shared_ptr<ShmChannel> map(int fd, std::size_t size = 0)
+    {
+        auto fail = [&](std::error_code err, const char* what) {
+            ::close(fd);
+            throw std::system_error{ err, what };
+        };
+
+        auto validate = size == 0;
+        if (validate) {
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                fail({ errno, std::system_category() }, "fstat");
+            }
+            size = static_cast<std::size_t>(info.st_size);
+            if (size < regionSize(1)) {
+                fail(std::make_error_code(std::errc::invalid_argument), "shared memory is not a channel");
+            }
+        }
+
+        auto* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            fail({ errno, std::system_category() }, "mmap");
+        }
+
+        auto channel = std::shared_ptr<ShmChannel>{ new ShmChannel{ fd, base, size } };
+
+        if (validate) {
+            auto* header = channel->m_header;
+            if (header->m_magic.load(std::memory_order_acquire) != shm_channel_detail::s_magic
+                || header->m_elementSize != sizeof(T) || header->m_elementAlign != alignof(T)
+                || size < regionSize(header->m_capacity)) {
+                throw std::system_error{ std::make_error_code(std::errc::invalid_argument), "shared memory is not a channel of this type" };
+            }
+        }
+        return channel;
+    }
+
+    void* at(Index_type index) { return m_slots[index & (m_header->m_capacity - 1)].m_data; }
+
+    int         m_fd;
+    void*       m_base;
+    std::size_t m_size;
+    Header*     m_header;
+    Slot*       m_slots;
+};
+
+template <ShmTransferable T>
+class ShmSender
+{
+public:
+    using Index_type = shm_channel_detail::Index_type;
+
+    ShmSender(std::shared_ptr<ShmChannel<T>> channel)
+        : m_channel{ std::move(channel) }
+        , m_cachedHead{ m_channel->m_header->m_head.load(std::memory_order_acquire) }
+    {
+    }
+
+    ~ShmSender() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            auto& header = *m_channel->m_header;
+            header.m_tail.fetch_or(shm_channel_detail::s_closedBit, std::memory_order_release);
+            shm_channel_detail::futexWake(header.m_tail, INT_MAX);
+            m_channel.reset();
+        }
+    }
+
+    ShmSender(const ShmSender&)               = delete;
+    ShmSender<T>& operator=(const ShmSender&) = delete;
+
+    ShmSender(ShmSender&&)               = default;
+    ShmSender<T>& operator=(ShmSender&&) = default;
+
+    // blocks while the ring is full
+    CHANNEL_SEND_TYPE send(const T& value) { return sendImpl(true, value); }
+
+    // never blocks
+    CHANNEL_SEND_TYPE try_send(const T& value) { return sendImpl(false, value); }
+
+private:
+    CHANNEL_SEND_TYPE sendImpl(bool block, const T& value)
+    {
+        assert(m_channel);
+        using namespace shm_channel_detail;
+
+        auto& header   = *m_channel->m_header;
+        auto  capacity = header.m_capacity;
+        auto  tail     = header.m_tail.load(std::memory_order_relaxed);
+
+        if (header.m_receiverClosed.load(std::memory_order_acquire) != 0) {
+            return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+        }
+        if (distance(m_cachedHead, tail) == capacity) {
+            m_cachedHead = header.m_head.load(std::memory_order_acquire);
+
+            while (distance(m_cachedHead, tail) == capacity && (m_cachedHead & s_closedBit) == 0) {
+                if (!block) {
+                    return channel_detail::sendError(std::errc::no_buffer_space, "send on full channel");
+                }
+                park(header);
+            }
+            if ((m_cachedHead & s_closedBit) != 0) {
+                return channel_detail::sendError(std::errc::broken_pipe, "send on closed channel");
+            }
+        }
+
+        std::memcpy(m_channel->at(tail), std::addressof(value), sizeof(T));
+        header.m_tail.store((tail + 1) & s_indexMask, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (header.m_receiverParked.exchange(0, std::memory_order_relaxed) != 0) {
+            futexWake(header.m_tail, 1);
+        }
+        return channel_detail::sendSuccess();
+    }
+
+    // waits until the receiver moves m_head (or closes), refreshing the cached head
+    void park(shm_channel_detail::Header& header)
+    {
+        header.m_senderParked.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto head = header.m_head.load(std::memory_order_acquire);
+        if (head == m_cachedHead) {
+            shm_channel_detail::futexWait(header.m_head, head);
+            head = header.m_head.load(std::memory_order_acquire);
+        }
+
+        header.m_senderParked.store(0, std::memory_order_relaxed);
+        m_cachedHead = head;
+    }
+
+    std::shared_ptr<ShmChannel<T>> m_channel;
+    Index_type                     m_cachedHead;
+};
+
+template <ShmTransferable T>
+class ShmReceiver
+{
+public:
+    using Index_type = shm_channel_detail::Index_type;
+
+    ShmReceiver(std::shared_ptr<ShmChannel<T>> channel)
+        : m_channel{ std::move(channel) }
+        , m_cachedTail{ m_channel->m_header->m_tail.load(std::memory_order_acquire) }
+    {
+    }
+
+    ~ShmReceiver() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            auto& header = *m_channel->m_header;
+            header.m_receiverClosed.store(1, std::memory_order_release);
+            header.m_head.fetch_or(shm_channel_detail::s_closedBit, std::memory_order_release);
+            shm_channel_detail::futexWake(header.m_head, INT_MAX);
+            m_channel.reset();
+        }
+    }
+
+    ShmReceiver(const ShmReceiver&)               = delete;
+    ShmReceiver<T>& operator=(const ShmReceiver&) = delete;
+
+    ShmReceiver(ShmReceiver&&)               = default;
+    ShmReceiver<T>& operator=(ShmReceiver&&) = default;
+
+    // blocks while the ring is empty; elements sent before the sender closed are still received
+    CHANNEL_RECEIVE_TYPE(T) receive() { return receiveImpl(true); }
+
+    // never blocks
+    CHANNEL_RECEIVE_TYPE(T) try_receive() { return receiveImpl(false); }
+
+private:
+    CHANNEL_RECEIVE_TYPE(T) receiveImpl(bool block)
+    {
+        assert(m_channel);
+        using namespace shm_channel_detail;
+
+        auto& header = *m_channel->m_header;
+        auto  head   = header.m_head.load(std::memory_order_relaxed);
+
+        if (distance(head, m_cachedTail) == 0) {
+            m_cachedTail = header.m_tail.load(std::memory_order_acquire);
+
+            while (distance(head, m_cachedTail) == 0) {
+                if ((m_cachedTail & s_closedBit) != 0) {
+                    return channel_detail::receiveError<T>(std::errc::broken_pipe, "receive on closed channel");
+                }
+                if (!block) {
+                    return channel_detail::receiveError<T>(
+                        std::errc::resource_unavailable_try_again, "receive on empty channel"
+                    );
+                }
+                park(header, head);
+            }
+        }
+
+        auto slot = typename ShmChannel<T>::Slot{};
+        std::memcpy(slot.m_data, m_channel->at(head), sizeof(T));
+        header.m_head.store((head + 1) & s_indexMask, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (header.m_senderParked.exchange(0, std::memory_order_relaxed) != 0) {
+            futexWake(header.m_head, 1);
+        }
+        return channel_detail::receiveSuccess(std::bit_cast<T>(slot));
+    }
+
+    // waits until the sender moves m_tail (or closes), refreshing the cached tail
+    void park(shm_channel_detail::Header& header, Index_type head)
+    {
+        using namespace shm_channel_detail;
+
+        header.m_receiverParked.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto tail = header.m_tail.load(std::memory_order_acquire);
+        if (distance(head, tail) == 0 && (tail & s_closedBit) == 0) {
+            futexWait(header.m_tail, tail);
+            tail = header.m_tail.load(std::memory_order_acquire);
+        }
+
+        header.m_receiverParked.store(0, std::memory_order_relaxed);
+        m_cachedTail = tail;
+    }
+
+    std::shared_ptr<ShmChannel<T>> m_channel;
+    Index_type                     m_cachedTail;
+};
+
+// both ends in this process, mostly useful before handing channel->fd() to another process. see ShmChannel
+template <ShmTransferable T>
+std::pair<ShmSender<T>, ShmReceiver<T>> makeShmChannel(std::size_t capacity)
+{
+    auto channel = ShmChannel<T>::create(capacity);
+    return std::make_pair(ShmSender<T>{ channel }, ShmReceiver<T>{ channel });
+}
+
+#endif /* end of include guard: SHM_CHANNEL_HPP_R4N8XT2C */
@@ -0,0 +1,164 @@
+#include "shm_channel.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+constexpr std::int64_t s_count = 2'000'000;
+
+struct Sample
+{
+    std::int64_t m_sequence;
+    double       m_value;
+    char         m_tag[16];
+};
+
+// runs fn in a child process, returns its pid
+template <typename Fn>
+pid_t spawn(Fn&& fn)
+{
+    auto pid = ::fork();
+    if (pid == 0) {
+        fn();
+        std::cout.flush();
+        ::_exit(0);
+    }
+    return pid;
+}
+
+template <typename Fn>
+void measure(const std::string& name, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << std::format("{}: {} ms ({} msg/s)\n", name, duration.count(), s_count / duration.count() * 1000);
+}
+
+void consume(ShmReceiver<Sample> rx)
+{
+    auto sum = std::int64_t{ 0 };
+    auto ok  = true;
+    for (auto expected = std::int64_t{ 0 };; ++expected) {
+        auto [sample, err] = rx.receive();
+        if (err) {
+            break;
+        }
+        ok  = ok && sample.m_sequence == expected;
+        sum += sample.m_sequence;
+    }
+    std::cout << std::format("child: sum {} ({})\n", sum, ok && sum == s_count * (s_count - 1) / 2 ? "ok" : "MISMATCH");
+}
+
+void produce(ShmSender<Sample> tx)
+{
+    for (auto i = std::int64_t{ 0 }; i < s_count; ++i) {
+        if (tx.send(Sample{ .m_sequence = i, .m_value = i * 0.5, .m_tag = "sample" })) {
+            break;
+        }
+    }
+}
+
+// the memfd is inherited by the child, which maps it again through its fd
+void memfd()
+{
+    auto channel = ShmChannel<Sample>::create(1024);
+
+    measure("memfd channel", [&] {
+        auto pid = spawn([&] { consume(ShmReceiver<Sample>{ ShmChannel<Sample>::open(channel->fd()) }); });
+        produce(ShmSender<Sample>{ channel });
+        ::waitpid(pid, nullptr, 0);
+    });
+}
+
+// an unrelated process would find the channel by name the same way
+void named()
+{
+    auto name    = std::format("/channel-test-{}", ::getpid());
+    auto channel = ShmChannel<Sample>::create(name, 1024);
+
+    auto pid = spawn([&] {
+        auto [sample, err] = ShmReceiver<Sample>{ ShmChannel<Sample>::open(name) }.receive();
+        std::cout << std::format("child: got {} '{}' by name\n", sample.m_sequence, sample.m_tag);
+    });
+
+    // the receiver may attach before or after this send, it waits for the element either way
+    ShmSender<Sample>{ channel }.send(Sample{ .m_sequence = 42, .m_value = 0, .m_tag = "named" });
+    ::waitpid(pid, nullptr, 0);
+    ShmChannel<Sample>::unlink(name);
+
+    try {
+        ShmChannel<double>::open(channel->fd());
+    } catch (const std::system_error& e) {
+        std::cout << std::format("open with the wrong type: {}\n", e.what());
+    }
+}
+
+// the same transfer written to and read back from a socket, one message per syscall
+void socket()
+{
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+
+    measure("socketpair", [&] {
+        auto pid = spawn([&] {
+            ::close(fds[0]);
+            auto sample = Sample{};
+            auto sum    = std::int64_t{ 0 };
+            while (::read(fds[1], &sample, sizeof(sample)) == sizeof(sample)) {
+                sum += sample.m_sequence;
+            }
+            std::cout << std::format("child: sum {}\n", sum);
+        });
+        ::close(fds[1]);
+        for (auto i = std::int64_t{ 0 }; i < s_count; ++i) {
+            auto sample = Sample{ .m_sequence = i, .m_value = i * 0.5, .m_tag = "sample" };
+            ::write(fds[0], &sample, sizeof(sample));
+        }
+        ::close(fds[0]);
+        ::waitpid(pid, nullptr, 0);
+    });
+}
+
+void closeSemantics()
+{
+    {
+        auto [tx, rx] = makeShmChannel<int>(4);
+        auto [value, err] = rx.try_receive();
+        std::cout << std::format("try_receive on empty channel: {}\n", err.message());
+        rx.close();
+        std::cout << std::format("send after receiver closed: {}\n", tx.send(1).message());
+    }
+    {
+        auto [tx, rx] = makeShmChannel<int>(4);
+        for (int i = 0; i < 4; ++i) {
+            tx.send(i);
+        }
+        std::cout << std::format("try_send on full channel: {}\n", tx.try_send(4).message());
+        tx.close();
+
+        auto sum = 0;
+        while (true) {
+            auto [value, err] = rx.receive();
+            if (err) {
+                std::cout << std::format("received {} after sender closed, then: {}\n", sum, err.message());
+                break;
+            }
+            sum += value;
+        }
+    }
+}
+
+int main()
+{
+    closeSemantics();
+    named();
+    memfd();
+    socket();
+}
@@ -0,0 +1,525 @@
+#ifndef SPSC_CHANNEL_HPP_K7W2QZ9D
+#define SPSC_CHANNEL_HPP_K7W2QZ9D
+
+#include "channel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+template <std::move_constructible T>
+class SpscSender;
+
+template <std::move_constructible T>
+class SpscReceiver;
+
+template <std::move_constructible T>
+class SpscSendSlot;
+
+template <std::move_constructible T>
+class SpscReceiveSlot;
+
+// single-producer single-consumer channel backed by a lock-free power-of-two ring buffer.
+//
+// m_head is only written by the receiver and m_tail only by the sender; each side keeps a cached copy of the other
+// side's index so the shared cache line is only touched when the ring looks empty or full. a side only parks (via
+// std::atomic::wait) when the ring is actually empty or full, and the other side only calls notify when it is the one
+// clearing the parked flag, so a park costs at most one wake up.
+//
+// the highest bit of each index is set when its owner closes, which wakes up the parked peer. the sender/receiver
+// counts are what decide whether an operation fails with broken_pipe, same as Channel.
+template <std::move_constructible T>
+struct SpscChannel
+{
+    friend class SpscSender<T>;
+    friend class SpscReceiver<T>;
+    friend class SpscSendSlot<T>;
+    friend class SpscReceiveSlot<T>;
+
+public:
+    using Index_type = std::uint32_t;    // 32-bit so atomic::wait maps directly to a futex
+
+    static constexpr Index_type s_closedBit   = Index_type{ 1 } << 31;
+    static constexpr Index_type s_indexMask   = s_closedBit - 1;
+    static constexpr std::size_t s_maxCapacity = std::size_t{ 1 } << 30;
+
+    // capacity is rounded up to the next power of two
+    explicit SpscChannel(std::size_t capacity)
+        : m_capacity{ static_cast<Index_type>(std::bit_ceil(std::max(capacity, std::size_t{ 1 }))) }
+        , m_slots{ std::make_unique<Slot[]>(m_capacity) }
+    {
+        assert(capacity <= s_maxCapacity);
+    }
+
+    ~SpscChannel()
+    {
+        auto head = m_head.load(std::memory_order_relaxed) & s_indexMask;
+        auto tail = m_tail.load(std::memory_order_relaxed) & s_indexMask;
+        for (; head != tail; head = (head + 1) & s_indexMask) {
+            std::destroy_at(at(head));
+        }
+    }
+
+    SpscChannel(const SpscChannel&)            = delete;
+    SpscChannel& operator=(const SpscChannel&) = delete;
+
+    std::size_t capacity() const { return m_capacity; }
+
+private:
+    struct Slot
+    {
+        alignas(T) std::byte m_data[sizeof(T)];
+    };
+
+    T* at(Index_type index) { return std::launder(reinterpret_cast<T*>(m_slots[index & (m_capacity - 1)].m_data)); }
+
+    static Index_type distance(Index_type from, Index_type to) { return (to - from) & s_indexMask; }
+
+    // sender side: waits until the slot at m_tail is free. returns std::errc{} on success
+    std::errc reserve(bool block)
+    {
+        if (m_receivers.load(std::memory_order_acquire) == 0) {
+            return std::errc::broken_pipe;
+        }
+
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if (distance(m_cachedHead, tail) == m_capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+
+            while (distance(m_cachedHead, tail) == m_capacity) {
+                if (m_receivers.load(std::memory_order_acquire) == 0) {
+                    return std::errc::broken_pipe;
+                }
+                if (!block) {
+                    return std::errc::no_buffer_space;
+                }
+                parkSender();
+            }
+        }
+        return {};
+    }
+
+    // sender side: makes the element constructed at tail visible to the receiver
+    void publish(Index_type tail)
+    {
+        m_tail.store((tail + 1) & s_indexMask, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_receiverParked.exchange(false, std::memory_order_relaxed)) {
+            m_tail.notify_one();
+        }
+    }
+
+    // waits until the receiver moves m_head (or closes), refreshing the cached head
+    void parkSender()
+    {
+        m_senderParked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto head = m_head.load(std::memory_order_acquire);
+        if (head == m_cachedHead) {
+            m_head.wait(head, std::memory_order_acquire);
+            head = m_head.load(std::memory_order_acquire);
+        }
+
+        m_senderParked.store(false, std::memory_order_relaxed);
+        m_cachedHead = head;
+    }
+
+    // receiver side: waits until there is an element at m_head. returns std::errc{} on success
+    std::errc acquire()
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (distance(head, m_cachedTail) == 0) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+            while (distance(head, m_cachedTail) == 0) {
+                if (m_senders.load(std::memory_order_acquire) == 0) {
+                    return std::errc::broken_pipe;
+                }
+                parkReceiver(head);
+            }
+        }
+        return {};
+    }
+
+    // receiver side: destroys the element at head and hands its slot back to the sender
+    void release(Index_type head)
+    {
+        std::destroy_at(at(head));
+        m_head.store((head + 1) & s_indexMask, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_senderParked.exchange(false, std::memory_order_relaxed)) {
+            m_head.notify_one();
+        }
+    }
+
+    // waits until the sender moves m_tail (or closes), refreshing the cached tail
+    void parkReceiver(Index_type head)
+    {
+        m_receiverParked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto tail = m_tail.load(std::memory_order_acquire);
+        if (distance(head, tail) == 0 && (tail & s_closedBit) == 0) {
+            m_tail.wait(tail, std::memory_order_acquire);
+            tail = m_tail.load(std::memory_order_acquire);
+        }
+
+        m_receiverParked.store(false, std::memory_order_relaxed);
+        m_cachedTail = tail;
+    }
+
+    // read-mostly
+    const Index_type        m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<std::size_t> m_senders   = 0;
+    std::atomic<std::size_t> m_receivers = 0;
+
+    // receiver side
+    alignas(channel_detail::s_cacheLineSize) std::atomic<Index_type> m_head = 0;
+    Index_type                                                       m_cachedTail = 0;
+    std::atomic<bool>                                                m_receiverParked = false;
+    bool                                                             m_peeked = false;    // a SpscReceiveSlot is alive
+
+    // sender side
+    alignas(channel_detail::s_cacheLineSize) std::atomic<Index_type> m_tail = 0;
+    Index_type                                                       m_cachedHead = 0;
+    std::atomic<bool>                                                m_senderParked = false;
+    bool                                                             m_claimed = false;    // a SpscSendSlot is alive
+};
+
+template <std::move_constructible T>
+class SpscSender
+{
+public:
+    SpscSender(std::shared_ptr<SpscChannel<T>> channel)
+        : m_channel{ std::move(channel) }
+    {
+        m_channel->m_senders.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~SpscSender() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            m_channel->m_senders.fetch_sub(1, std::memory_order_acq_rel);
+            m_channel->m_tail.fetch_or(SpscChannel<T>::s_closedBit, std::memory_order_release);
+            m_channel->m_tail.notify_all();
+            m_channel.reset();
+        }
+    }
+
+    SpscSender(const SpscSender&)               = delete;
+    SpscSender<T>& operator=(const SpscSender&) = delete;
+
+    SpscSender(SpscSender&&)               = default;
+    SpscSender<T>& operator=(SpscSender&&) = default;
+
+    // blocks while the ring is full
+    CHANNEL_SEND_TYPE send(T&& value) { return emplaceImpl(true, std::move(value)); }
+
+    // never blocks; if the ring is full, value is left untouched
+    CHANNEL_SEND_TYPE try_send(T&& value) { return emplaceImpl(false, std::move(value)); }
+
+    // blocks while the ring is full, then constructs the element directly inside the ring
+    template <typename... Args>
+        requires std::constructible_from<T, Args...>
+    CHANNEL_SEND_TYPE emplace(Args&&... args)
+    {
+        return emplaceImpl(true, std::forward<Args>(args)...);
+    }
+
+    // blocks while the ring is full, then hands out the free slot so the element can be built in place:
+    //
+    //     auto [slot, err] = sender.claim();
+    //     slot.emplace(...);    // then fill it through *slot
+    //     slot.commit();
+    //
+    // the receiver only sees the element once committed. dropping the slot without committing discards it.
+    // only one slot can be claimed at a time: while it is alive, claim, send and emplace fail with
+    // resource_unavailable_try_again.
+    CHANNEL_RECEIVE_TYPE(SpscSendSlot<T>) claim()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        if (channel.m_claimed) {
+            return channel_detail::receiveError<SpscSendSlot<T>>(
+                std::errc::resource_unavailable_try_again, "claim while a slot is claimed"
+            );
+        }
+        if (auto err = channel.reserve(true); err != std::errc{}) {
+            return channel_detail::receiveError<SpscSendSlot<T>>(err, "send on closed channel");
+        }
+        channel.m_claimed = true;
+        auto tail         = channel.m_tail.load(std::memory_order_relaxed);
+        return channel_detail::receiveSuccess(SpscSendSlot<T>{ m_channel, tail });
+    }
+
+private:
+    template <typename... Args>
+    CHANNEL_SEND_TYPE emplaceImpl(bool block, Args&&... args)
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        if (channel.m_claimed) {
+            return channel_detail::sendError(std::errc::resource_unavailable_try_again, "send while a slot is claimed");
+        }
+        if (auto err = channel.reserve(block); err == std::errc::no_buffer_space) {
+            return channel_detail::sendError(err, "send on full channel");
+        } else if (err != std::errc{}) {
+            return channel_detail::sendError(err, "send on closed channel");
+        }
+
+        auto tail = channel.m_tail.load(std::memory_order_relaxed);
+        std::construct_at(channel.at(tail), std::forward<Args>(args)...);
+        channel.publish(tail);
+
+        return channel_detail::sendSuccess();
+    }
+
+    std::shared_ptr<SpscChannel<T>> m_channel;
+};
+
+template <std::move_constructible T>
+class SpscReceiver
+{
+public:
+    SpscReceiver(std::shared_ptr<SpscChannel<T>> channel)
+        : m_channel{ std::move(channel) }
+    {
+        m_channel->m_receivers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~SpscReceiver() { close(); }
+
+    void close()
+    {
+        if (m_channel) {
+            m_channel->m_receivers.fetch_sub(1, std::memory_order_acq_rel);
+            m_channel->m_head.fetch_or(SpscChannel<T>::s_closedBit, std::memory_order_release);
+            m_channel->m_head.notify_all();
+            m_channel.reset();
+        }
+    }
+
+    SpscReceiver(const SpscReceiver&)               = delete;
+    SpscReceiver<T>& operator=(const SpscReceiver&) = delete;
+
+    SpscReceiver(SpscReceiver&&)               = default;
+    SpscReceiver<T>& operator=(SpscReceiver&&) = default;
+
+    // blocks while the ring is empty; elements sent before the sender closed are still received
+    CHANNEL_RECEIVE_TYPE(T) receive()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        if (channel.m_peeked) {
+            return channel_detail::receiveError<T>(
+                std::errc::resource_unavailable_try_again, "receive while a slot is peeked"
+            );
+        }
+        if (auto err = channel.acquire(); err != std::errc{}) {
+            return channel_detail::receiveError<T>(err, "receive on closed channel");
+        }
+
+        auto head  = channel.m_head.load(std::memory_order_relaxed);
+        auto value = std::move(*channel.at(head));
+        channel.release(head);
+
+        return channel_detail::receiveSuccess(std::move(value));
+    }
+
+    // blocks while the ring is empty, then gives access to the next element where it sits in the ring. the slot goes
+    // back to the sender once the returned slot is released (or dropped). only one slot can be peeked at a time: while
+    // it is alive, peek and receive fail with resource_unavailable_try_again.
+    CHANNEL_RECEIVE_TYPE(SpscReceiveSlot<T>) peek()
+    {
+        assert(m_channel);
+        auto& channel = *m_channel;
+
+        if (channel.m_peeked) {
+            return channel_detail::receiveError<SpscReceiveSlot<T>>(
+                std::errc::resource_unavailable_try_again, "peek while a slot is peeked"
+            );
+        }
+        if (auto err = channel.acquire(); err != std::errc{}) {
+            return channel_detail::receiveError<SpscReceiveSlot<T>>(err, "receive on closed channel");
+        }
+        channel.m_peeked = true;
+        auto head        = channel.m_head.load(std::memory_order_relaxed);
+        return channel_detail::receiveSuccess(SpscReceiveSlot<T>{ m_channel, head });
+    }
+
+private:
+    std::shared_ptr<SpscChannel<T>> m_channel;
+};
+
+// a free slot claimed by SpscSender::claim, see there
+template <std::move_constructible T>
+class SpscSendSlot
+{
+public:
+    friend class SpscSender<T>;
+
+    SpscSendSlot() = default;
+
+    ~SpscSendSlot() { reset(); }
+
+    SpscSendSlot(const SpscSendSlot&)            = delete;
+    SpscSendSlot& operator=(const SpscSendSlot&) = delete;
+
+    SpscSendSlot(SpscSendSlot&& other) noexcept
+        : m_channel{ std::move(other.m_channel) }
+        , m_tail{ other.m_tail }
+        , m_constructed{ std::exchange(other.m_constructed, false) }
+    {
+    }
+
+    SpscSendSlot& operator=(SpscSendSlot&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            m_channel     = std::move(other.m_channel);
+            m_tail        = other.m_tail;
+            m_constructed = std::exchange(other.m_constructed, false);
+        }
+        return *this;
+    }
+
+    template <typename... Args>
+        requires std::constructible_from<T, Args...>
+    T& emplace(Args&&... args)
+    {
+        assert(m_channel && !m_constructed);
+        auto* value   = std::construct_at(m_channel->at(m_tail), std::forward<Args>(args)...);
+        m_constructed = true;
+        return *value;
+    }
+
+    T& operator*() const
+    {
+        assert(m_channel && m_constructed);
+        return *m_channel->at(m_tail);
+    }
+
+    T* operator->() const { return &**this; }
+
+    void commit()
+    {
+        assert(m_channel && m_constructed);
+        auto channel       = std::move(m_channel);
+        m_constructed      = false;
+        channel->m_claimed = false;
+        channel->publish(m_tail);
+    }
+
+private:
+    using Index_type = SpscChannel<T>::Index_type;
+
+    SpscSendSlot(std::shared_ptr<SpscChannel<T>> channel, Index_type tail)
+        : m_channel{ std::move(channel) }
+        , m_tail{ tail }
+    {
+    }
+
+    // discards the element if one was constructed and lets the sender claim again
+    void reset()
+    {
+        if (m_channel) {
+            if (m_constructed) {
+                std::destroy_at(m_channel->at(m_tail));
+            }
+            m_channel->m_claimed = false;
+            m_channel.reset();
+        }
+        m_constructed = false;
+    }
+
+    std::shared_ptr<SpscChannel<T>> m_channel;
+    Index_type                        m_tail        = 0;
+    bool                              m_constructed = false;
+};
+
+// the element at the front of the ring, handed out by SpscReceiver::peek
+template <std::move_constructible T>
+class SpscReceiveSlot
+{
+public:
+    friend class SpscReceiver<T>;
+
+    SpscReceiveSlot() = default;
+
+    ~SpscReceiveSlot() { release(); }
+
+    SpscReceiveSlot(const SpscReceiveSlot&)            = delete;
+    SpscReceiveSlot& operator=(const SpscReceiveSlot&) = delete;
+
+    SpscReceiveSlot(SpscReceiveSlot&& other) noexcept
+        : m_channel{ std::move(other.m_channel) }
+        , m_head{ other.m_head }
+    {
+    }
+
+    SpscReceiveSlot& operator=(SpscReceiveSlot&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            m_channel = std::move(other.m_channel);
+            m_head    = other.m_head;
+        }
+        return *this;
+    }
+
+    T& operator*() const
+    {
+        assert(m_channel);
+        return *m_channel->at(m_head);
+    }
+
+    T* operator->() const { return &**this; }
+
+    // destroys the element and hands the slot back to the sender
+    void release()
+    {
+        if (m_channel) {
+            auto channel      = std::move(m_channel);
+            channel->m_peeked = false;
+            channel->release(m_head);
+        }
+    }
+
+private:
+    using Index_type = SpscChannel<T>::Index_type;
+
+    SpscReceiveSlot(std::shared_ptr<SpscChannel<T>> channel, Index_type head)
+        : m_channel{ std::move(channel) }
+        , m_head{ head }
+    {
+    }
+
+    std::shared_ptr<SpscChannel<T>> m_channel;
+    Index_type                        m_head = 0;
+};
+
+// capacity is rounded up to the next power of two
+template <std::move_constructible T>
+std::pair<SpscSender<T>, SpscReceiver<T>> makeSpscChannel(std::size_t capacity)
+{
+    auto channel = std::make_shared<SpscChannel<T>>(capacity);
+    return std::make_pair(SpscSender<T>{ channel }, SpscReceiver<T>{ channel });
+}
+
+#endif /* end of include guard: SPSC_CHANNEL_HPP_K7W2QZ9D */
@@ -0,0 +1,154 @@
+#include "channel.hpp"
+#include "spsc_channel.hpp"
+
+#include <array>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+
+constexpr int s_count = 10'000'000;
+
+template <typename Fn>
+void measure(const std::string& name, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << std::format("{}: {} ms ({} msg/s)\n", name, duration.count(), s_count / duration.count() * 1000);
+}
+
+// the same hand-off done through the mutex + deque channel and through the SPSC ring
+template <typename Tx, typename Rx>
+void handOff(Tx tx, Rx rx)
+{
+    std::jthread producer{ [tx = std::move(tx)]() mutable {
+        for (int i = 0; i < s_count; ++i) {
+            if (tx.send(int{ i })) {
+                break;
+            }
+        }
+    } };
+
+    long long sum = 0;
+    while (true) {
+        auto [value, err] = rx.receive();
+        if (err) {
+            break;
+        }
+        sum += value;
+    }
+
+    auto expected = static_cast<long long>(s_count) * (s_count - 1) / 2;
+    std::cout << std::format("sum: {} ({})\n", sum, sum == expected ? "ok" : "MISMATCH");
+}
+
+void closeSemantics()
+{
+    {
+        auto [tx, rx] = makeSpscChannel<int>(4);
+        rx.close();
+        auto err = tx.send(1);
+        std::cout << std::format("send after receiver closed: {}\n", err.message());
+    }
+    {
+        auto [tx, rx] = makeSpscChannel<int>(3);    // rounded up to 4
+        for (int i = 0; i < 4; ++i) {
+            tx.send(int{ i });
+        }
+        auto err = tx.try_send(4);
+        std::cout << std::format("try_send on full ring: {}\n", err.message());
+
+        tx.close();
+        while (true) {
+            auto [value, err] = rx.receive();
+            if (err) {
+                std::cout << std::format("receive after sender closed: {}\n", err.message());
+                break;
+            }
+            std::cout << std::format("received: {}\n", value);
+        }
+    }
+}
+
+// a large payload that is built and read where it sits in the ring, never moved
+struct Frame
+{
+    int                     m_id;
+    std::array<float, 4096> m_samples;
+};
+
+void inPlace()
+{
+    auto [tx, rx] = makeSpscChannel<Frame>(8);
+
+    std::jthread producer{ [tx = std::move(tx)]() mutable {
+        for (int i = 0; i < 4; ++i) {
+            auto [slot, err] = tx.claim();
+            if (err) {
+                break;
+            }
+            auto& frame = slot.emplace(i);
+            for (auto& sample : frame.m_samples) {
+                sample = static_cast<float>(i) * 0.5f;
+            }
+            slot.commit();
+        }
+        tx.emplace(4, std::array<float, 4096>{});
+    } };
+
+    while (true) {
+        auto [slot, err] = rx.peek();
+        if (err) {
+            break;
+        }
+        std::cout << std::format("frame {}: first sample {}\n", slot->m_id, slot->m_samples.front());
+        slot.release();
+    }
+}
+
+// a slot keeps the channel alive after its endpoint is gone, and blocks the other operations of its side meanwhile
+void slotLifetime()
+{
+    {
+        auto [tx, rx] = makeSpscChannel<std::string>(4);
+        auto [slot, err] = tx.claim();
+        slot.emplace("claimed");
+        auto sendErr = tx.send("sent while claimed");
+        std::cout << std::format("send while a slot is claimed: {}\n", sendErr.message());
+
+        tx.close();
+        slot.commit();
+        auto [value, receiveErr] = rx.receive();
+        std::cout << std::format("committed after sender closed: {}\n", value);
+    }
+    {
+        auto [tx, rx] = makeSpscChannel<std::string>(4);
+        tx.send("peeked");
+        tx.send("after");
+        auto [slot, err] = rx.peek();
+        auto [value, receiveErr] = rx.receive();
+        std::cout << std::format("receive while a slot is peeked: {}\n", receiveErr.message());
+
+        rx.close();
+        std::cout << std::format("peeked after receiver closed: {}\n", *slot);
+    }
+}
+
+int main()
+{
+    closeSemantics();
+    inPlace();
+    slotLifetime();
+
+    measure("Channel (mutex + deque)", [] {
+        auto [tx, rx] = makeChannel<int>(1024);
+        handOff(std::move(tx), std::move(rx));
+    });
+
+    measure("SpscChannel", [] {
+        auto [tx, rx] = makeSpscChannel<int>(1024);
+        handOff(std::move(tx), std::move(rx));
+    });
+}
@@ -0,0 +1,257 @@
+#ifndef CORO_TASK_HPP_R4WM8ZJD
+#define CORO_TASK_HPP_R4WM8ZJD
+
+#include "task_arena.hpp"
+
+#include <cassert>
+#include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+template <typename T = void>
+    requires std::same_as<T, void> || std::move_constructible<T>
+class Task;
+
+namespace coro_task_detail
+{
+    // called when a task finishes with nobody awaiting it, i.e. one started by syncWait
+    struct DoneCallback
+    {
+        void (*m_func)(void*) = nullptr;
+        void* m_arg           = nullptr;
+    };
+
+    class PromiseBase
+    {
+    public:
+        // a coroutine frame small enough for a slot comes from the task arena, larger ones from the heap
+        static void* operator new(std::size_t size)
+        {
+            return threadpool_detail::ArenaAllocator<std::byte>{}.allocate(size);
+        }
+
+        static void operator delete(void* pointer, std::size_t size)
+        {
+            threadpool_detail::ArenaAllocator<std::byte>{}.deallocate(static_cast<std::byte*>(pointer), size);
+        }
+
+        // resumes the awaiter directly from the finishing coroutine's thread, without going through a queue
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                auto& promise = handle.promise();
+                if (promise.m_continuation) {
+                    return promise.m_continuation;
+                }
+                if (promise.m_done.m_func) {
+                    promise.m_done.m_func(promise.m_done.m_arg);
+                }
+                return std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept { }
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter        final_suspend() const noexcept { return {}; }
+
+        std::coroutine_handle<> m_continuation;
+        DoneCallback            m_done;
+    };
+
+    template <typename T>
+    class Promise : public PromiseBase
+    {
+    public:
+        Task<T> get_return_object();
+
+        template <typename U>
+            requires std::convertible_to<U&&, T>
+        void return_value(U&& value)
+        {
+            m_result.template emplace<1>(std::forward<U>(value));
+        }
+
+        void unhandled_exception() { m_result.template emplace<2>(std::current_exception()); }
+
+        T result()
+        {
+            if (m_result.index() == 2) {
+                std::rethrow_exception(std::get<2>(m_result));
+            }
+            return std::move(std::get<1>(m_result));
+        }
+
+    private:
+        std::variant<std::monostate, T, std::exception_ptr> m_result;
+    };
+
+    template <>
+    class Promise<void> : public PromiseBase
+    {
+    public:
+        Task<void> get_return_object();
+
+        void return_void() { }
+
+        void unhandled_exception() { m_exception = std::current_exception(); }
+
+        void result()
+        {
+            if (m_exception) {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+    private:
+        std::exception_ptr m_exception;
+    };
+}
+
+// a lazily started coroutine producing a T. it runs when awaited, on the awaiting thread until it awaits something
+// else (e.g. pool.schedule()), and when it finishes the awaiting coroutine is resumed right away on the same thread.
+// an exception escaping the coroutine is rethrown at the co_await.
+//
+//     Task<int> step(ThreadPool& pool, int value)
+//     {
+//         co_await pool.schedule();
+//         co_return value + 1;
+//     }
+//
+//     Task<int> handler(ThreadPool& pool)
+//     {
+//         auto value = co_await step(pool, 0);
+//         co_return co_await step(pool, value);
+//     }
+//
+//     auto result = syncWait(handler(pool));
+template <typename T>
+    requires std::same_as<T, void> || std::move_constructible<T>
+class Task
+{
+public:
+    using promise_type = coro_task_detail::Promise<T>;
+
+    Task() = default;
+
+    ~Task()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept
+        : m_handle{ std::exchange(other.m_handle, nullptr) }
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    // a task can be awaited once
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                m_handle.promise().m_continuation = awaiting;
+                return m_handle;
+            }
+
+            T await_resume() { return m_handle.promise().result(); }
+
+            std::coroutine_handle<promise_type> m_handle;
+        };
+
+        assert(m_handle && !m_handle.done());
+        return Awaiter{ m_handle };
+    }
+
+    template <typename U>
+    friend U syncWait(Task<U> task);
+
+private:
+    friend promise_type;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : m_handle{ handle }
+    {
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace coro_task_detail
+{
+    template <typename T>
+    Task<T> Promise<T>::get_return_object()
+    {
+        return Task<T>{ std::coroutine_handle<Promise<T>>::from_promise(*this) };
+    }
+
+    inline Task<void> Promise<void>::get_return_object()
+    {
+        return Task<void>{ std::coroutine_handle<Promise<void>>::from_promise(*this) };
+    }
+}
+
+// runs task to completion, blocking the calling thread; the bridge from plain code into coroutines. must not be
+// called from a pool worker the task needs, that worker would be blocked. if the pool is stopped with
+// ignoreQueuedTasks while the task waits in its queue, the exception thrown at the co_await (see
+// ThreadPool::schedule) is rethrown here unless the task handles it.
+template <typename T>
+T syncWait(Task<T> task)
+{
+    struct Done
+    {
+        std::mutex              m_mutex;
+        std::condition_variable m_cv;
+        bool                    m_done = false;
+    } done;
+
+    // notifying under the lock: once the waiter sees m_done the finishing thread no longer touches done
+    auto& promise  = task.m_handle.promise();
+    promise.m_done = {
+        .m_func =
+            [](void* arg) {
+                auto&            done = *static_cast<Done*>(arg);
+                std::unique_lock lock{ done.m_mutex };
+                done.m_done = true;
+                done.m_cv.notify_one();
+            },
+        .m_arg = &done,
+    };
+
+    task.m_handle.resume();
+
+    std::unique_lock lock{ done.m_mutex };
+    done.m_cv.wait(lock, [&] { return done.m_done; });
+    return promise.result();
+}
+
+#endif /* end of include guard: CORO_TASK_HPP_R4WM8ZJD */
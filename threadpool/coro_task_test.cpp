@@ -0,0 +1,125 @@
+#include "coro_task.hpp"
+#include "threadpool.hpp"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+constexpr int s_steps = 200'000;
+
+std::size_t threadHash()
+{
+    return std::hash<std::thread::id>{}(std::this_thread::get_id()) % 0x10000;
+}
+
+Task<int> step(ThreadPool& pool, int value)
+{
+    co_await pool.schedule();
+    co_return value + 1;
+}
+
+Task<int> chain(ThreadPool& pool, int steps)
+{
+    auto value = 0;
+    for (int i = 0; i < steps; ++i) {
+        value = co_await step(pool, value);
+    }
+    co_return value;
+}
+
+Task<std::string> fetch(ThreadPool& pool, std::string name)
+{
+    auto before = threadHash();
+    co_await pool.schedule(ThreadPool::Priority::High);
+    co_return std::format("{} (from thread {:x} to {:x})", name, before, threadHash());
+}
+
+Task<void> fail(ThreadPool& pool)
+{
+    co_await pool.schedule();
+    throw std::runtime_error{ "handler failed" };
+}
+
+Task<> handler(ThreadPool& pool)
+{
+    auto first  = co_await fetch(pool, "first");
+    auto second = co_await fetch(pool, "second");
+    std::cout << std::format("handler: {}, {}\n", first, second);
+
+    try {
+        co_await fail(pool);
+    } catch (const std::exception& e) {
+        std::cout << std::format("handler: caught '{}'\n", e.what());
+    }
+}
+
+Task<std::string> cancelled(ThreadPool& pool)
+{
+    try {
+        co_await pool.schedule();
+        co_return "resumed";
+    } catch (const std::system_error& e) {
+        co_return std::format("cancelled: {}", e.code().message());
+    }
+}
+
+// a coroutine still queued when the pool is stopped with ignoreQueuedTasks is resumed with an exception, its
+// syncWait returns instead of blocking forever
+void stopWhileQueued()
+{
+    using namespace std::chrono_literals;
+
+    ThreadPool pool{ 1 };
+    std::latch busy{ 1 };
+    pool.post([&busy] {
+        busy.count_down();
+        std::this_thread::sleep_for(100ms);
+    });
+    busy.wait();
+
+    auto result = std::string{};
+    auto waiter = std::jthread{ [&] { result = syncWait(cancelled(pool)); } };
+    while (pool.queuedTasks() == 0) {
+        std::this_thread::sleep_for(1ms);
+    }
+    pool.stopPool(true);
+    waiter.join();
+    std::cout << std::format("stopped while queued: {}\n", result);
+}
+
+// the same chain of steps, each one enqueued and waited on through its future from a plain function
+int futureChain(ThreadPool& pool, int steps)
+{
+    auto value = 0;
+    for (int i = 0; i < steps; ++i) {
+        value = pool.enqueue([value] { return value + 1; }).get();
+    }
+    return value;
+}
+
+template <typename Fn>
+void measure(const std::string& name, Fn&& fn)
+{
+    auto start    = std::chrono::steady_clock::now();
+    auto result   = fn();
+    auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    std::cout << std::format(
+        "{}: {} steps in {} ms ({} steps/s)\n", name, result, duration.count() * 1000, result / duration.count()
+    );
+}
+
+int main()
+{
+    ThreadPool pool{ 2 };
+
+    syncWait(handler(pool));
+    stopWhileQueued();
+
+    measure("co_await chain", [&] { return syncWait(chain(pool, s_steps)); });
+    measure("enqueue + get chain", [&] { return futureChain(pool, s_steps); });
+}
@@ -0,0 +1,155 @@
+#ifndef CPU_TOPOLOGY_HPP_N6TB2XQA
+#define CPU_TOPOLOGY_HPP_N6TB2XQA
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sched.h>
+
+// the CPUs this thread may run on, grouped by NUMA node as listed in /sys/devices/system/node. a machine or kernel
+// without NUMA support shows up as a single node holding every CPU. linux only.
+class CpuTopology
+{
+public:
+    static constexpr std::size_t s_unknownNode = static_cast<std::size_t>(-1);
+
+    // nodes left without an allowed CPU are dropped, so node indices may differ from the kernel's numbering
+    static CpuTopology discover()
+    {
+        auto allowed = allowedCpus();
+        auto nodes   = std::vector<std::vector<int>>{};
+
+        auto error = std::error_code{};
+        for (const auto& entry : std::filesystem::directory_iterator{ "/sys/devices/system/node", error }) {
+            auto name = entry.path().filename().string();
+            if (!name.starts_with("node") || name.size() == 4) {
+                continue;
+            }
+
+            auto file = std::ifstream{ entry.path() / "cpulist" };
+            auto list = std::string{};
+            std::getline(file, list);
+
+            auto cpus = std::vector<int>{};
+            for (auto cpu : parseCpuList(list)) {
+                if (std::ranges::binary_search(allowed, cpu)) {
+                    cpus.push_back(cpu);
+                }
+            }
+            if (!cpus.empty()) {
+                nodes.push_back(std::move(cpus));
+            }
+        }
+
+        if (nodes.empty()) {
+            nodes.push_back(std::move(allowed));
+        }
+        std::ranges::sort(nodes, {}, [](const auto& cpus) { return cpus.front(); });
+        return CpuTopology{ std::move(nodes) };
+    }
+
+    explicit CpuTopology(std::vector<std::vector<int>> nodes)
+        : m_nodes{ std::move(nodes) }
+    {
+        for (auto& cpus : m_nodes) {
+            std::ranges::sort(cpus);
+        }
+    }
+
+    const std::vector<std::vector<int>>& nodes() const { return m_nodes; }
+
+    // every CPU of every node, sorted
+    std::vector<int> cpus() const
+    {
+        auto cpus = std::vector<int>{};
+        for (const auto& node : m_nodes) {
+            cpus.insert(cpus.end(), node.begin(), node.end());
+        }
+        std::ranges::sort(cpus);
+        return cpus;
+    }
+
+    // s_unknownNode if cpu is in no node
+    std::size_t nodeOf(int cpu) const
+    {
+        for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+            if (std::ranges::binary_search(m_nodes[i], cpu)) {
+                return i;
+            }
+        }
+        return s_unknownNode;
+    }
+
+    // the CPUs in the calling thread's affinity mask, sorted
+    static std::vector<int> allowedCpus()
+    {
+        auto set = cpu_set_t{};
+        auto cpus = std::vector<int>{};
+        if (::sched_getaffinity(0, sizeof(set), &set) != 0) {
+            return cpus;
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    // restricts the calling thread to cpus, returns false if the kernel refused
+    static bool setCurrentThreadAffinity(std::span<const int> cpus)
+    {
+        auto set = cpu_set_t{};
+        CPU_ZERO(&set);
+        for (auto cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+
+    static std::optional<int> currentCpu()
+    {
+        auto cpu = ::sched_getcpu();
+        return cpu >= 0 ? std::optional{ cpu } : std::nullopt;
+    }
+
+    // parses the kernel's cpu list format, e.g. "0-3,8,10-11"
+    static std::vector<int> parseCpuList(std::string_view list)
+    {
+        auto cpus = std::vector<int>{};
+        while (!list.empty()) {
+            auto comma = list.find(',');
+            auto range = list.substr(0, comma);
+            list       = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+            auto first = 0;
+            auto last  = 0;
+            auto [end, ec] = std::from_chars(range.data(), range.data() + range.size(), first);
+            if (ec != std::errc{}) {
+                continue;
+            }
+            last = first;
+            if (end != range.data() + range.size() && *end == '-') {
+                std::from_chars(end + 1, range.data() + range.size(), last);
+            }
+            for (auto cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+private:
+    std::vector<std::vector<int>> m_nodes;
+};
+
+#endif /* end of include guard: CPU_TOPOLOGY_HPP_N6TB2XQA */
@@ -0,0 +1,345 @@
+#ifndef TASK_ARENA_HPP_H3KD7RWE
+#define TASK_ARENA_HPP_H3KD7RWE
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace threadpool_detail
+{
+    inline constexpr std::size_t s_slotSize  = 128;    // two cache lines
+    inline constexpr std::size_t s_batchSize = 32;     // slots moved at once between a thread and the shared stack
+
+    // fixed size blocks recycled through per-thread free lists. a thread frees into its own list; once that holds two
+    // batches one of them goes to a shared stack, which a thread whose list ran empty takes a batch from. new memory
+    // is only allocated when the shared stack is empty too, so a steady flow of tasks stops allocating after warm up.
+    class SlotArena
+    {
+    public:
+        struct alignas(64) Slot
+        {
+            std::byte m_bytes[s_slotSize];
+        };
+
+        static void* allocate()
+        {
+            auto& cache = localCache();
+            if (cache.m_head == nullptr) {
+                cache.m_head  = shared().take();
+                cache.m_count = cache.m_head->m_count;
+            }
+            auto* slot   = cache.m_head;
+            cache.m_head = slot->m_next;
+            --cache.m_count;
+            return slot;
+        }
+
+        static void deallocate(void* pointer) noexcept
+        {
+            auto& cache  = localCache();
+            cache.m_head = ::new (pointer) FreeSlot{ .m_next = cache.m_head };
+            if (++cache.m_count == 2 * s_batchSize) {
+                auto* batch = cache.m_head;
+                auto* last  = batch;
+                for (std::size_t i = 1; i < s_batchSize; ++i) {
+                    last = last->m_next;
+                }
+                cache.m_head   = std::exchange(last->m_next, nullptr);
+                cache.m_count -= s_batchSize;
+                shared().give(batch, s_batchSize);
+            }
+        }
+
+    private:
+        struct FreeSlot
+        {
+            FreeSlot*   m_next      = nullptr;
+            FreeSlot*   m_nextBatch = nullptr;    // only set on the first slot of a batch in the shared stack
+            std::size_t m_count     = 0;          // likewise, the number of slots in the batch
+        };
+
+        struct Shared
+        {
+            // never returns an empty batch
+            FreeSlot* take()
+            {
+                std::unique_lock lock{ m_mutex };
+                if (m_batches != nullptr) {
+                    return std::exchange(m_batches, m_batches->m_nextBatch);
+                }
+
+                auto& chunk = m_chunks.emplace_back(std::make_unique<Slot[]>(s_batchSize));
+                auto* head  = static_cast<FreeSlot*>(nullptr);
+                for (std::size_t i = s_batchSize; i-- > 0;) {
+                    head = ::new (&chunk[i]) FreeSlot{ .m_next = head };
+                }
+                head->m_count = s_batchSize;
+                return head;
+            }
+
+            void give(FreeSlot* batch, std::size_t count)
+            {
+                std::unique_lock lock{ m_mutex };
+                batch->m_count     = count;
+                batch->m_nextBatch = std::exchange(m_batches, batch);
+            }
+
+            std::mutex                           m_mutex;
+            FreeSlot*                            m_batches = nullptr;
+            std::vector<std::unique_ptr<Slot[]>> m_chunks;
+        };
+
+        // a thread's slots go back to the shared stack when it exits
+        struct LocalCache
+        {
+            ~LocalCache()
+            {
+                if (m_head != nullptr) {
+                    shared().give(m_head, m_count);
+                }
+            }
+
+            FreeSlot*   m_head  = nullptr;
+            std::size_t m_count = 0;
+        };
+
+        // leaked on purpose: a ThreadPool with static storage is destroyed after a function-local static would be,
+        // and its workers still free slots and return their caches while it stops
+        static Shared& shared()
+        {
+            static Shared& s_shared = *new Shared;
+            return s_shared;
+        }
+
+        static LocalCache& localCache()
+        {
+            thread_local LocalCache s_cache;
+            return s_cache;
+        }
+    };
+
+    // a std::allocator replacement taking blocks that fit in a slot from SlotArena, e.g. for the shared state of a
+    // std::promise
+    template <typename T>
+    struct ArenaAllocator
+    {
+        using value_type = T;
+
+        ArenaAllocator() = default;
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>&)
+        {
+        }
+
+        T* allocate(std::size_t count)
+        {
+            if (fits(count)) {
+                return static_cast<T*>(SlotArena::allocate());
+            }
+            return std::allocator<T>{}.allocate(count);
+        }
+
+        void deallocate(T* pointer, std::size_t count) noexcept
+        {
+            if (fits(count)) {
+                SlotArena::deallocate(pointer);
+            } else {
+                std::allocator<T>{}.deallocate(pointer, count);
+            }
+        }
+
+        static bool fits(std::size_t count)
+        {
+            return alignof(T) <= alignof(SlotArena::Slot) && count <= s_slotSize / sizeof(T);
+        }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>&) const
+        {
+            return true;
+        }
+    };
+
+    // a type-erased void() callable occupying one slot: the closure is stored inline when it fits, on the heap
+    // otherwise. it is also the node of the intrusive lists ThreadPool queues tasks in, so queueing never allocates.
+    struct TaskNode
+    {
+        using Manage_type = void (*)(TaskNode*, bool run);
+
+        Manage_type                           m_manage;    // runs the closure if run, then destroys it and the node
+        TaskNode*                             m_next = nullptr;
+        TaskNode*                             m_prev = nullptr;
+        std::chrono::steady_clock::time_point m_queued;    // set when pushed to the shared queue, for aging
+
+        alignas(16) std::byte m_storage[s_slotSize - 32];
+    };
+
+    static_assert(sizeof(TaskNode) == s_slotSize);
+
+    template <typename Func>
+    TaskNode* makeTask(Func&& func)
+    {
+        using F = std::decay_t<Func>;
+
+        constexpr auto inlined = sizeof(F) <= sizeof(TaskNode::m_storage) && alignof(F) <= 16;
+
+        auto* node = ::new (SlotArena::allocate()) TaskNode;
+        try {
+            if constexpr (inlined) {
+                ::new (node->m_storage) F(std::forward<Func>(func));
+            } else {
+                ::new (node->m_storage) F*(new F(std::forward<Func>(func)));
+            }
+        } catch (...) {
+            node->~TaskNode();
+            SlotArena::deallocate(node);
+            throw;
+        }
+
+        node->m_manage = [](TaskNode* node, bool run) {
+            F* func = nullptr;
+            if constexpr (inlined) {
+                func = std::launder(reinterpret_cast<F*>(node->m_storage));
+            } else {
+                func = *std::launder(reinterpret_cast<F**>(node->m_storage));
+            }
+
+            // also when func throws
+            auto release = [&] {
+                if constexpr (inlined) {
+                    std::destroy_at(func);
+                } else {
+                    delete func;
+                }
+                node->~TaskNode();
+                SlotArena::deallocate(node);
+            };
+
+            if (run) {
+                try {
+                    (*func)();
+                } catch (...) {
+                    release();
+                    throw;
+                }
+            }
+            release();
+        };
+        return node;
+    }
+
+    // runs the task and frees it
+    inline void runTask(TaskNode* node)
+    {
+        node->m_manage(node, true);
+    }
+
+    // frees the task without running it
+    inline void destroyTask(TaskNode* node)
+    {
+        node->m_manage(node, false);
+    }
+
+    // an intrusive doubly linked list of tasks, owns them
+    class TaskList
+    {
+    public:
+        TaskList() = default;
+
+        ~TaskList() { clear(); }
+
+        TaskList(const TaskList&)            = delete;
+        TaskList& operator=(const TaskList&) = delete;
+
+        TaskList(TaskList&& other) noexcept
+            : m_head{ std::exchange(other.m_head, nullptr) }
+            , m_tail{ std::exchange(other.m_tail, nullptr) }
+            , m_size{ std::exchange(other.m_size, 0) }
+        {
+        }
+
+        TaskList& operator=(TaskList&&) = delete;
+
+        void pushBack(TaskNode* node)
+        {
+            node->m_next = nullptr;
+            node->m_prev = m_tail;
+            (m_tail ? m_tail->m_next : m_head) = node;
+            m_tail = node;
+            ++m_size;
+        }
+
+        // moves every task of other to the back of this list
+        void splice(TaskList& other)
+        {
+            if (other.empty()) {
+                return;
+            }
+            other.m_head->m_prev         = m_tail;
+            (m_tail ? m_tail->m_next : m_head) = other.m_head;
+            m_tail                       = other.m_tail;
+            m_size                      += other.m_size;
+
+            other.m_head = other.m_tail = nullptr;
+            other.m_size                = 0;
+        }
+
+        // nullptr if empty
+        TaskNode* popFront()
+        {
+            auto* node = m_head;
+            if (node != nullptr) {
+                m_head                             = node->m_next;
+                (m_head ? m_head->m_prev : m_tail) = nullptr;
+                --m_size;
+            }
+            return node;
+        }
+
+        // nullptr if empty
+        TaskNode* popBack()
+        {
+            auto* node = m_tail;
+            if (node != nullptr) {
+                m_tail                             = node->m_prev;
+                (m_tail ? m_tail->m_next : m_head) = nullptr;
+                --m_size;
+            }
+            return node;
+        }
+
+        TaskNode* front() const { return m_head; }
+
+        void clear()
+        {
+            while (auto* node = popFront()) {
+                destroyTask(node);
+            }
+        }
+
+        template <typename Func>
+        void forEach(Func&& func)
+        {
+            for (auto* node = m_head; node != nullptr; node = node->m_next) {
+                func(*node);
+            }
+        }
+
+        std::size_t size() const { return m_size; }
+        bool        empty() const { return m_size == 0; }
+
+    private:
+        TaskNode*   m_head = nullptr;
+        TaskNode*   m_tail = nullptr;
+        std::size_t m_size = 0;
+    };
+}
+
+#endif /* end of include guard: TASK_ARENA_HPP_H3KD7RWE */
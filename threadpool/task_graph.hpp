@@ -0,0 +1,277 @@
+#ifndef TASK_GRAPH_HPP_Q8CZL3VN
+#define TASK_GRAPH_HPP_Q8CZL3VN
+
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// a DAG of tasks run on a ThreadPool. a task is only queued once all the tasks it depends on have finished, so no
+// worker ever blocks waiting for another task. the same graph can be run again once the previous run completed.
+//
+//     TaskGraph graph;
+//     auto load  = graph.add([] { ... });
+//     auto parse = load.then([] { ... });
+//     auto index = graph.add([] { ... }, load);
+//     graph.add([] { ... }, parse, index);    // runs after both
+//     graph.run(pool).get();
+//
+// if a task throws, the tasks that depend on it (directly or not) are skipped and the run completes with the first
+// exception thrown.
+class TaskGraph
+{
+public:
+    using Clock_type    = std::chrono::steady_clock;
+    using Duration_type = std::chrono::nanoseconds;
+
+    struct RunStats
+    {
+        Duration_type wallTime;        // from run() to the last task finishing
+        Duration_type criticalPath;    // the longest sum of task run times along a dependency chain
+        std::size_t   tasksRun;        // tasks skipped because a dependency threw are not counted
+    };
+
+    // refers to a task in the graph, cheap to copy
+    class Task
+    {
+    public:
+        friend class TaskGraph;
+
+        // adds a task that runs after this one
+        template <std::invocable Func>
+        Task then(Func&& func)
+        {
+            return m_graph->add(std::forward<Func>(func), *this);
+        }
+
+        // makes other run after this one
+        Task& precede(Task other)
+        {
+            m_graph->addEdge(m_index, other.m_index);
+            return *this;
+        }
+
+        // makes this run after other
+        Task& succeed(Task other)
+        {
+            m_graph->addEdge(other.m_index, m_index);
+            return *this;
+        }
+
+        std::size_t index() const { return m_index; }
+
+    private:
+        Task(TaskGraph* graph, std::size_t index)
+            : m_graph{ graph }
+            , m_index{ index }
+        {
+        }
+
+        TaskGraph*  m_graph;
+        std::size_t m_index;
+    };
+
+    TaskGraph() = default;
+
+    TaskGraph(const TaskGraph&)            = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // adds a task that runs after every task in dependencies
+    template <std::invocable Func, std::same_as<Task>... Dependencies>
+    Task add(Func&& func, Dependencies... dependencies)
+    {
+        assert(!m_running.load());
+        auto index = m_nodes.size();
+        m_nodes.emplace_back(std::forward<Func>(func));
+        (addEdge(dependencies.m_index, index), ...);
+        return { this, index };
+    }
+
+    std::size_t size() const { return m_nodes.size(); }
+
+    // queues every task without dependencies on pool. the future completes once every task has finished (or was
+    // skipped). throws std::invalid_argument if the graph has a cycle. the graph must not be modified, run again or
+    // destroyed before the future completes.
+    std::future<RunStats> run(ThreadPool& pool)
+    {
+        auto wasRunning = m_running.exchange(true);
+        assert(!wasRunning && "TaskGraph is already running");
+
+        if (hasCycle()) {
+            m_running.store(false);
+            throw std::invalid_argument{ "TaskGraph has a cycle" };
+        }
+
+        m_promise   = {};
+        m_exception = nullptr;
+        m_failed.clear();
+        m_tasksRun.store(0, std::memory_order_relaxed);
+        m_remaining.store(m_nodes.size(), std::memory_order_relaxed);
+        for (auto& node : m_nodes) {
+            node.m_pending.store(node.m_predecessors.size(), std::memory_order_relaxed);
+            node.m_skip.store(false, std::memory_order_relaxed);
+            node.m_path = Duration_type::zero();
+        }
+
+        auto future = m_promise.get_future();
+        m_start     = Clock_type::now();
+
+        if (m_nodes.empty()) {
+            finish();
+            return future;
+        }
+
+        for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+            if (m_nodes[i].m_predecessors.empty()) {
+                schedule(pool, i);
+            }
+        }
+        return future;
+    }
+
+private:
+    struct Node
+    {
+        template <typename Func>
+        explicit Node(Func&& func)
+            : m_func{ std::forward<Func>(func) }
+        {
+        }
+
+        ThreadPool::Task_type    m_func;
+        std::vector<std::size_t> m_successors;
+        std::vector<std::size_t> m_predecessors;
+
+        // per run
+        std::atomic<std::size_t> m_pending = 0;        // predecessors not finished yet
+        std::atomic<bool>        m_skip    = false;    // a predecessor threw or was skipped
+        Duration_type            m_path    = {};       // the longest chain of run times ending with this task
+    };
+
+    void addEdge(std::size_t from, std::size_t to)
+    {
+        assert(!m_running.load());
+        assert(from < m_nodes.size() && to < m_nodes.size());
+        m_nodes[from].m_successors.push_back(to);
+        m_nodes[to].m_predecessors.push_back(from);
+    }
+
+    // Kahn's algorithm: a cycle leaves some tasks that never reach zero remaining predecessors
+    bool hasCycle() const
+    {
+        auto pending = std::vector<std::size_t>(m_nodes.size());
+        auto ready   = std::vector<std::size_t>{};
+        for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+            pending[i] = m_nodes[i].m_predecessors.size();
+            if (pending[i] == 0) {
+                ready.push_back(i);
+            }
+        }
+
+        auto visited = std::size_t{ 0 };
+        while (!ready.empty()) {
+            auto index = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (auto successor : m_nodes[index].m_successors) {
+                if (--pending[successor] == 0) {
+                    ready.push_back(successor);
+                }
+            }
+        }
+        return visited != m_nodes.size();
+    }
+
+    void schedule(ThreadPool& pool, std::size_t index)
+    {
+        pool.post([this, &pool, index] { execute(pool, index); });
+    }
+
+    void execute(ThreadPool& pool, std::size_t index)
+    {
+        auto& node = m_nodes[index];
+
+        // every predecessor has finished, and published its m_path, before this task was queued
+        auto longest = Duration_type::zero();
+        for (auto predecessor : node.m_predecessors) {
+            longest = std::max(longest, m_nodes[predecessor].m_path);
+        }
+
+        auto skip = node.m_skip.load(std::memory_order_relaxed);
+        if (!skip) {
+            auto start = Clock_type::now();
+            try {
+                node.m_func();
+                m_tasksRun.fetch_add(1, std::memory_order_relaxed);
+            } catch (...) {
+                if (!m_failed.test_and_set()) {
+                    m_exception = std::current_exception();
+                }
+                skip = true;
+            }
+            longest += Clock_type::now() - start;
+        }
+        node.m_path = longest;
+
+        for (auto successor : node.m_successors) {
+            auto& next = m_nodes[successor];
+            if (skip) {
+                next.m_skip.store(true, std::memory_order_relaxed);
+            }
+            if (next.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                schedule(pool, successor);
+            }
+        }
+
+        if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            finish();
+        }
+    }
+
+    // called by the last task to finish, every other task's writes are visible through m_remaining
+    void finish()
+    {
+        auto stats = RunStats{
+            .wallTime     = std::chrono::duration_cast<Duration_type>(Clock_type::now() - m_start),
+            .criticalPath = Duration_type::zero(),
+            .tasksRun     = m_tasksRun.load(std::memory_order_relaxed),
+        };
+        for (const auto& node : m_nodes) {
+            stats.criticalPath = std::max(stats.criticalPath, node.m_path);
+        }
+
+        // the promise is moved out first: once the future is ready the graph may be run again or destroyed
+        auto promise   = std::move(m_promise);
+        auto exception = std::exchange(m_exception, nullptr);
+        m_running.store(false);
+
+        if (exception) {
+            promise.set_exception(exception);
+        } else {
+            promise.set_value(stats);
+        }
+    }
+
+    std::deque<Node> m_nodes;    // a deque since Node is not movable
+
+    // per run
+    std::atomic<bool>        m_running   = false;
+    std::atomic<std::size_t> m_remaining = 0;
+    std::atomic<std::size_t> m_tasksRun  = 0;
+    std::atomic_flag         m_failed;
+    std::exception_ptr       m_exception;
+    std::promise<RunStats>   m_promise;
+    Clock_type::time_point   m_start;
+};
+
+#endif /* end of include guard: TASK_GRAPH_HPP_Q8CZL3VN */
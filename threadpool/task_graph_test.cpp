@@ -0,0 +1,121 @@
+#include "task_graph.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+double toMs(TaskGraph::Duration_type duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void printStats(const char* name, const TaskGraph::RunStats& stats)
+{
+    std::cout << std::format(
+        "{}: {} tasks, wall {:.1f} ms, critical path {:.1f} ms\n",
+        name,
+        stats.tasksRun,
+        toMs(stats.wallTime),
+        toMs(stats.criticalPath)
+    );
+}
+
+// a diamond of sleeping tasks: the critical path is a -> c -> d (10 + 40 + 10 ms) whatever the number of threads
+void diamond(std::size_t numThreads)
+{
+    ThreadPool pool{ numThreads };
+    TaskGraph  graph;
+
+    auto a = graph.add([] { std::this_thread::sleep_for(10ms); });
+    auto b = a.then([] { std::this_thread::sleep_for(20ms); });
+    auto c = a.then([] { std::this_thread::sleep_for(40ms); });
+    graph.add([] { std::this_thread::sleep_for(10ms); }, b, c);
+
+    // the same graph run again, each run starts from a clean state
+    for (int run = 0; run < 3; ++run) {
+        auto stats = graph.run(pool).get();
+        printStats(std::format("diamond, {} threads, run {}", numThreads, run).c_str(), stats);
+    }
+}
+
+// a graph much wider than the pool, on a single worker: nothing blocks so it still completes
+void wide()
+{
+    ThreadPool pool{ 1 };
+    TaskGraph  graph;
+
+    std::atomic<int> sum = 0;
+
+    auto source = graph.add([] {});
+    auto sink   = graph.add([&sum] { std::cout << std::format("wide: sink sees sum {}\n", sum.load()); });
+    for (int i = 1; i <= 1000; ++i) {
+        auto task = source.then([&sum, i] { sum += i; });
+        task.precede(sink);
+    }
+
+    printStats("wide, 1 thread", graph.run(pool).get());
+}
+
+// a chain of then()s run in order, even with many workers
+void chain()
+{
+    ThreadPool pool{ 4, ThreadPool::Scheduling::WorkStealing };
+    TaskGraph  graph;
+
+    int  value = 0;
+    auto task  = graph.add([&value] { value = 1; });
+    for (int i = 0; i < 10; ++i) {
+        task = task.then([&value] { value *= 2; });
+    }
+
+    graph.run(pool).get();
+    std::cout << std::format("chain: {} (expected {})\n", value, 1 << 10);
+}
+
+void failure()
+{
+    ThreadPool pool{ 2 };
+    TaskGraph  graph;
+
+    std::atomic<int> ran = 0;
+
+    auto ok     = graph.add([&ran] { ++ran; });
+    auto thrown = graph.add([] { throw std::runtime_error{ "task failed" }; });
+    thrown.then([&ran] { ++ran; }).then([&ran] { ++ran; });    // skipped
+    ok.then([&ran] { ++ran; });                                  // still runs
+
+    try {
+        graph.run(pool).get();
+    } catch (const std::exception& e) {
+        std::cout << std::format("failure: '{}', {} tasks ran\n", e.what(), ran.load());
+    }
+
+    TaskGraph cyclic;
+    auto      x = cyclic.add([] {});
+    auto      y = x.then([] {});
+    y.precede(x);
+
+    try {
+        cyclic.run(pool);
+    } catch (const std::invalid_argument& e) {
+        std::cout << std::format("cycle: '{}'\n", e.what());
+    }
+}
+
+int main()
+{
+    diamond(1);
+    diamond(4);
+    wide();
+    chain();
+    failure();
+
+    TaskGraph empty;
+    ThreadPool pool{ 1 };
+    printStats("empty", empty.run(pool).get());
+}
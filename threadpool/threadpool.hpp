@@ -1,24 +1,227 @@
 #ifndef THREADPOOL_HPP_YWONTBSQ
 #define THREADPOOL_HPP_YWONTBSQ
 
-#if __cplusplus >= 202302L
-#    include <functional>
-#else
+#if __cplusplus < 202302L
 #    include "move_only_function.hpp"
 #endif
 
+#include "cpu_topology.hpp"
+#include "task_arena.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
 #include <format>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <ranges>
 #include <thread>
 #include <type_traits>
 #include <vector>
 #include <deque>
 #include <mutex>
 #include <condition_variable>
+#include <system_error>
 
 #define USE_PACKAGED_TASK 0
 
+// define THREADPOOL_METRICS to 1 to make every worker keep the counters reported by ThreadPool::metrics. when it is 0
+// (the default) none of the bookkeeping is compiled in.
+#if not defined(THREADPOOL_METRICS)
+#    define THREADPOOL_METRICS 0
+#endif
+
+#if THREADPOOL_METRICS
+// a log2 histogram: bucket 0 counts durations under 1ns, bucket i those in [2^(i-1), 2^i) ns, the last one everything
+// longer
+struct DurationHistogram
+{
+    static constexpr std::size_t s_buckets = 40;    // the last bucket starts at 2^38 ns, about 4.6 minutes
+
+    std::array<std::uint64_t, s_buckets> counts = {};
+
+    static std::size_t bucketOf(std::chrono::nanoseconds duration)
+    {
+        auto ns = static_cast<std::uint64_t>(std::max(duration.count(), std::int64_t{ 0 }));
+        return std::min(static_cast<std::size_t>(std::bit_width(ns)), s_buckets - 1);
+    }
+
+    std::uint64_t count() const
+    {
+        auto total = std::uint64_t{ 0 };
+        for (auto count : counts) {
+            total += count;
+        }
+        return total;
+    }
+
+    // the upper bound of the bucket holding the given quantile (0 to 1), zero when empty
+    std::chrono::nanoseconds percentile(double quantile) const
+    {
+        auto total  = count();
+        auto target = static_cast<std::uint64_t>(quantile * static_cast<double>(total));
+        auto seen   = std::uint64_t{ 0 };
+        for (std::size_t i = 0; i < s_buckets; ++i) {
+            seen += counts[i];
+            if (seen > target || (seen == total && total != 0)) {
+                return std::chrono::nanoseconds{ std::int64_t{ 1 } << i };
+            }
+        }
+        return std::chrono::nanoseconds::zero();
+    }
+
+    DurationHistogram& operator+=(const DurationHistogram& other)
+    {
+        for (std::size_t i = 0; i < s_buckets; ++i) {
+            counts[i] += other.counts[i];
+        }
+        return *this;
+    }
+};
+
+// a snapshot of one worker's counters. with elastic sizing a worker slot is reused by later workers, which keep
+// adding to the same counters
+struct WorkerMetrics
+{
+    std::uint64_t            tasksExecuted = 0;
+    std::uint64_t            steals        = 0;    // tasks taken from another worker's deque, WorkStealing only
+    std::chrono::nanoseconds busyTime      = {};    // running tasks
+    std::chrono::nanoseconds idleTime      = {};    // everything else since the worker started: waiting, queue overhead
+    DurationHistogram        queueLatency;          // from enqueue to the task starting
+    DurationHistogram        runTime;
+
+    WorkerMetrics& operator+=(const WorkerMetrics& other)
+    {
+        tasksExecuted += other.tasksExecuted;
+        steals        += other.steals;
+        busyTime      += other.busyTime;
+        idleTime      += other.idleTime;
+        queueLatency  += other.queueLatency;
+        runTime       += other.runTime;
+        return *this;
+    }
+};
+
+struct PoolMetrics
+{
+    std::vector<WorkerMetrics> workers;    // one per worker slot
+
+    WorkerMetrics total() const
+    {
+        auto total = WorkerMetrics{};
+        for (const auto& worker : workers) {
+            total += worker;
+        }
+        return total;
+    }
+};
+
+namespace threadpool_detail
+{
+    // written by its worker only, so updates are plain loads and stores rather than read-modify-writes; read from
+    // anywhere by ThreadPool::metrics
+    struct alignas(64) WorkerCounters
+    {
+        using Clock_type = std::chrono::steady_clock;
+        using Counter    = std::atomic<std::uint64_t>;
+
+        static void add(Counter& counter, std::uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        static std::uint64_t nanoseconds(Clock_type::duration duration)
+        {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            return static_cast<std::uint64_t>(std::max(ns, std::int64_t{ 0 }));
+        }
+
+        void start(Clock_type::time_point now)
+        {
+            m_idleSince.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        // records the idle time up to now and marks the worker busy
+        void begin(Clock_type::time_point now, Clock_type::time_point queued)
+        {
+            auto idleSince = Clock_type::duration{ m_idleSince.load(std::memory_order_relaxed) };
+            add(m_idleTime, nanoseconds(now - Clock_type::time_point{ idleSince }));
+            add(m_queueLatency[DurationHistogram::bucketOf(now - queued)], 1);
+            m_busySince.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+            m_idleSince.store(0, std::memory_order_relaxed);
+        }
+
+        void end(Clock_type::time_point now, Clock_type::time_point started)
+        {
+            add(m_busyTime, nanoseconds(now - started));
+            add(m_runTime[DurationHistogram::bucketOf(now - started)], 1);
+            add(m_tasksExecuted, 1);
+            m_idleSince.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+            m_busySince.store(0, std::memory_order_relaxed);
+        }
+
+        // records the idle time up to now, the slot then reports no time passing until a worker starts on it again
+        void stop(Clock_type::time_point now)
+        {
+            auto idleSince = Clock_type::duration{ m_idleSince.load(std::memory_order_relaxed) };
+            if (idleSince.count() != 0) {
+                add(m_idleTime, nanoseconds(now - Clock_type::time_point{ idleSince }));
+            }
+            m_idleSince.store(0, std::memory_order_relaxed);
+        }
+
+        void steal() { add(m_steals, 1); }
+
+        // the time spent in the current state so far is counted too
+        WorkerMetrics snapshot(Clock_type::time_point now) const
+        {
+            auto metrics = WorkerMetrics{
+                .tasksExecuted = m_tasksExecuted.load(std::memory_order_relaxed),
+                .steals        = m_steals.load(std::memory_order_relaxed),
+                .busyTime      = std::chrono::nanoseconds{ m_busyTime.load(std::memory_order_relaxed) },
+                .idleTime      = std::chrono::nanoseconds{ m_idleTime.load(std::memory_order_relaxed) },
+                .queueLatency  = {},
+                .runTime       = {},
+            };
+            for (std::size_t i = 0; i < DurationHistogram::s_buckets; ++i) {
+                metrics.queueLatency.counts[i] = m_queueLatency[i].load(std::memory_order_relaxed);
+                metrics.runTime.counts[i]      = m_runTime[i].load(std::memory_order_relaxed);
+            }
+
+            auto since = [&](const std::atomic<Clock_type::rep>& value) {
+                auto rep = value.load(std::memory_order_relaxed);
+                if (rep == 0) {
+                    return std::chrono::nanoseconds::zero();
+                }
+                auto elapsed = nanoseconds(now - Clock_type::time_point{ Clock_type::duration{ rep } });
+                return std::chrono::nanoseconds{ static_cast<std::int64_t>(elapsed) };
+            };
+            metrics.busyTime += since(m_busySince);
+            metrics.idleTime += since(m_idleSince);
+            return metrics;
+        }
+
+        Counter                                           m_tasksExecuted = 0;
+        Counter                                           m_steals        = 0;
+        Counter                                           m_busyTime      = 0;    // ns
+        Counter                                           m_idleTime      = 0;    // ns
+        std::atomic<Clock_type::rep>                      m_busySince     = 0;    // 0 while idle
+        std::atomic<Clock_type::rep>                      m_idleSince     = 0;    // 0 while busy or not running
+        std::array<Counter, DurationHistogram::s_buckets> m_queueLatency  = {};
+        std::array<Counter, DurationHistogram::s_buckets> m_runTime       = {};
+    };
+}
+#endif
+
 class ThreadPool
 {
 public:
@@ -28,38 +231,288 @@ public:
     using Task_type = MoveOnlyFunction<void()>;    // until C++23's std::move_only_function is available, use this
 #endif
 
+    enum class Scheduling
+    {
+        // every worker pops from the one shared queue
+        GlobalQueue,
+
+        // every worker has its own deque: tasks enqueued from inside a task go to the deque of the worker running it,
+        // which pops them LIFO while idle workers steal FIFO from the other end. tasks enqueued from outside the pool
+        // go to the shared queue, which now only serves as an injection queue.
+        WorkStealing,
+    };
+
+    // the lane of the shared queue a task is put in, workers take from the highest non-empty lane first
+    enum class Priority
+    {
+        Low,
+        Normal,
+        High,
+    };
+
+    enum class Placement
+    {
+        // workers run wherever the scheduler puts them, restricted to Options::cpus if given
+        None,
+
+        // worker i is pinned to the i-th CPU of Options::cpus (wrapping around), one CPU each
+        PinCpus,
+
+        // workers are spread round robin over the NUMA nodes, each may run on any CPU of its node. in WorkStealing
+        // mode, tasks submitted from outside the pool go to a worker on the submitting thread's node and idle
+        // workers steal from their own node first.
+        SpreadNodes,
+    };
+
+    using Clock_type = std::chrono::steady_clock;
+
+    struct Options
+    {
+        Scheduling       scheduling = Scheduling::GlobalQueue;
+        Placement        placement  = Placement::None;
+        std::vector<int> cpus       = {};    // the CPUs to place workers on, every CPU the process may use if empty
+
+        // elastic sizing, GlobalQueue only. with maxThreads above the constructor's numThreads, a worker is added
+        // (at most one per spawnLatency) while the oldest queued task has waited longer than spawnLatency and no
+        // worker is idle. besides on every push and pop this is checked by a supervisor thread once the oldest task
+        // is due, so the pool also grows while every worker is stuck in a long task. a worker exits after keepAlive
+        // without a task as long as numThreads workers remain.
+        std::size_t          maxThreads   = 0;
+        Clock_type::duration spawnLatency = std::chrono::milliseconds{ 5 };
+        Clock_type::duration keepAlive    = std::chrono::seconds{ 10 };
+    };
+
+    // receives the exceptions escaping tasks submitted with post
+    using ExceptionHandler_type = std::function<void(std::exception_ptr)>;
+
 private:
-    std::vector<std::jthread> m_threads;
-    std::deque<Task_type>     m_tasks;
+    using TaskNode = threadpool_detail::TaskNode;
+    using TaskList = threadpool_detail::TaskList;
+
+    // the shared queue: one FIFO lane per Priority. a task is raised one lane for every aging interval it has waited,
+    // so a steady stream of high priority tasks delays the lower lanes but never starves them. at most one aged task
+    // per interval is taken ahead of a higher lane though, so an old backlog of low priority tasks cannot hold up a
+    // high priority task queued after it.
+    class TaskQueue
+    {
+    public:
+        static constexpr std::size_t s_lanes = 3;
+
+        void push(TaskList& tasks, Priority priority, Clock_type::time_point now)
+        {
+            tasks.forEach([&](TaskNode& task) { task.m_queued = now; });
+            m_size += tasks.size();
+            m_lanes[static_cast<std::size_t>(priority)].splice(tasks);
+        }
+
+        // must not be empty
+        TaskNode* pop()
+        {
+            auto* task = m_lanes[pick()].popFront();
+            --m_size;
+            return task;
+        }
+
+        // moves every queued task to the back of tasks
+        void takeAll(TaskList& tasks)
+        {
+            for (auto& lane : m_lanes) {
+                tasks.splice(lane);
+            }
+            m_size = 0;
+        }
+
+        std::size_t size() const { return m_size; }
+        std::size_t size(Priority priority) const { return m_lanes[static_cast<std::size_t>(priority)].size(); }
+        bool        empty() const { return m_size == 0; }
+
+        // an interval of zero disables aging
+        void setAging(Clock_type::duration interval) { m_aging = interval; }
+
+        // when the longest waiting task was queued, must not be empty
+        Clock_type::time_point oldest() const
+        {
+            auto oldest = Clock_type::time_point::max();
+            for (const auto& lane : m_lanes) {
+                if (!lane.empty()) {
+                    oldest = std::min(oldest, lane.front()->m_queued);
+                }
+            }
+            return oldest;
+        }
+
+    private:
+        // the highest non-empty lane, unless the oldest task of a lower one has a higher effective priority and no
+        // task was promoted that way within the last aging interval. the clock is only read when there is more than
+        // one lane to choose from.
+        std::size_t pick()
+        {
+            auto highest = s_lanes - 1;
+            while (m_lanes[highest].empty()) {
+                --highest;
+            }
+            if (m_size == m_lanes[highest].size() || m_aging == Clock_type::duration::zero()) {
+                return highest;
+            }
+
+            auto now  = Clock_type::now();
+            auto best = highest;
+            auto rank = highest;
+            for (std::size_t lane = highest; lane-- > 0;) {
+                if (m_lanes[lane].empty()) {
+                    continue;
+                }
+                auto waited    = now - m_lanes[lane].front()->m_queued;
+                auto effective = lane + static_cast<std::size_t>(waited / m_aging);
+                if (effective > rank) {
+                    best = lane;
+                    rank = effective;
+                }
+            }
+
+            if (best == highest || now - m_lastPromotion < m_aging) {
+                return highest;
+            }
+            m_lastPromotion = now;
+            return best;
+        }
+
+        std::array<TaskList, s_lanes> m_lanes;
+        std::size_t                   m_size  = 0;
+        Clock_type::duration          m_aging = std::chrono::milliseconds{ 100 };
+        Clock_type::time_point        m_lastPromotion;    // when an aged task was last taken ahead of a higher lane
+    };
+
+    // shared by the tasks of one parallelFor or enqueueBulk, the last one to finish completes the future with the
+    // first exception thrown, if any
+    class BulkCompletion
+    {
+    public:
+        explicit BulkCompletion(std::size_t count)
+            : m_remaining{ count }
+        {
+        }
+
+        std::future<void> future() { return m_promise.get_future(); }
+
+        template <typename Func>
+        void run(Func& func)
+        {
+            try {
+                func();
+            } catch (...) {
+                if (!m_failed.test_and_set(std::memory_order_relaxed)) {
+                    m_exception = std::current_exception();
+                }
+            }
+            if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                m_exception ? m_promise.set_exception(m_exception) : m_promise.set_value();
+            }
+        }
+
+    private:
+        std::promise<void>       m_promise;
+        std::atomic<std::size_t> m_remaining;
+        std::atomic_flag         m_failed;
+        std::exception_ptr       m_exception;
+    };
+
+    // a worker's own deque in WorkStealing mode. the mutex is only contended when a thief steals from it
+    struct alignas(64) LocalQueue
+    {
+        std::mutex m_mutex;
+        TaskList   m_tasks;
+    };
+
+    std::vector<std::jthread> m_threads;    // also holds the retired workers until reaped, guarded by m_mutex
+    std::atomic<std::size_t>  m_numWorkers = 0;
+    TaskQueue                 m_tasks;
     std::mutex                m_mutex;
     std::condition_variable   m_condition;
     bool                      m_stop = false;
+    ExceptionHandler_type     m_exceptionHandler;    // guarded by m_mutex
+
+    Scheduling                    m_scheduling;
+    std::unique_ptr<LocalQueue[]> m_localQueues;
+    std::size_t                   m_numQueues = 0;
+    std::atomic<std::size_t>      m_injected  = 0;    // m_tasks.size(), so idle workers can skip m_mutex when it is 0
+    std::atomic<std::size_t>      m_urgent    = 0;    // m_tasks.size(Priority::High), checked before the own deque
+    std::atomic<std::size_t>      m_sleeping  = 0;    // workers about to wait on m_condition
+    std::uint64_t                 m_wakeups   = 0;    // bumped under m_mutex to wake sleeping workers
+
+    std::vector<std::vector<std::size_t>> m_victims;        // per worker, the order to steal in
+    std::vector<std::vector<std::size_t>> m_nodeWorkers;    // per node, with Placement::SpreadNodes
+    std::vector<std::size_t>              m_cpuNodes;       // cpu to m_nodeWorkers index
+    std::atomic<std::size_t>              m_nextWorker = 0;
+    std::vector<std::vector<int>>         m_workerCpus;    // what placeWorkers gave each worker slot
+
+    // elastic sizing, all guarded by m_mutex
+    std::size_t                  m_minThreads = 0;
+    std::size_t                  m_maxThreads = 0;
+    Clock_type::duration         m_spawnLatency;
+    Clock_type::duration         m_keepAlive;
+    Clock_type::time_point       m_lastSpawn;
+    std::vector<std::thread::id> m_retired;      // exited workers still in m_threads
+    std::vector<std::size_t>     m_freeSlots;    // m_workerCpus (and m_metrics) indices no running worker uses
+    std::condition_variable      m_supervisorCondition;
+    bool                         m_supervisorIdle = false;    // waiting for a push, not for a deadline
+    std::jthread                 m_supervisor;
+
+#if THREADPOOL_METRICS
+    std::unique_ptr<threadpool_detail::WorkerCounters[]> m_metrics;    // one per worker slot
+#endif
+
+    // the worker the current thread is, if it is one
+    inline static thread_local ThreadPool* s_currentPool   = nullptr;
+    inline static thread_local std::size_t s_currentWorker = 0;
 
 public:
-    ThreadPool(size_t numThreads)
+    ThreadPool(size_t numThreads, Scheduling scheduling = Scheduling::GlobalQueue)
+        : ThreadPool{ numThreads, Options{ .scheduling = scheduling } }
     {
-        for (size_t i = 0; i < numThreads; ++i) {
-            m_threads.emplace_back([this] {
-                while (true) {
-                    Task_type task;
-                    {
-                        std::unique_lock lock{ m_mutex };
-
-                        m_condition.wait(lock, [this]() {
-                            auto condition = !m_tasks.empty() || m_stop;
-                            return condition;
-                        });
-
-                        if (m_stop && m_tasks.empty()) {
-                            return;
-                        }
+    }
 
-                        task = std::move(m_tasks.front());
-                        m_tasks.pop_front();
-                    }
-                    task();
-                }
-            });
+    // throws std::system_error if options.cpus has a CPU this thread is not allowed to run on, or if elastic sizing
+    // is asked for with WorkStealing
+    ThreadPool(size_t numThreads, Options options)
+        : m_scheduling{ options.scheduling }
+        , m_minThreads{ numThreads }
+        , m_maxThreads{ std::max(numThreads, options.maxThreads) }
+        , m_spawnLatency{ options.spawnLatency }
+        , m_keepAlive{ options.keepAlive }
+    {
+        if (m_maxThreads > m_minThreads && m_scheduling == Scheduling::WorkStealing) {
+            auto what = "ThreadPool: elastic sizing needs Scheduling::GlobalQueue";
+            throw std::system_error{ std::make_error_code(std::errc::invalid_argument), what };
+        }
+
+        m_workerCpus = placeWorkers(m_maxThreads, options);
+#if THREADPOOL_METRICS
+        m_metrics = std::make_unique<threadpool_detail::WorkerCounters[]>(m_maxThreads);
+#endif
+
+        if (m_scheduling == Scheduling::WorkStealing) {
+            m_numQueues   = numThreads;
+            m_localQueues = std::make_unique<LocalQueue[]>(numThreads);
+            m_victims     = stealOrder(numThreads);
+            for (size_t i = 0; i < numThreads; ++i) {
+                m_threads.emplace_back([this, i] {
+                    pinCurrentThread(m_workerCpus[i]);
+                    stealingWorker(i);
+                });
+            }
+            m_numWorkers.store(numThreads);
+            return;
+        }
+
+        for (auto slot = m_maxThreads; slot-- > 0;) {
+            m_freeSlots.push_back(slot);
+        }
+        for (size_t i = 0; i < numThreads; ++i) {
+            spawnWorker();
+        }
+        if (m_maxThreads > m_minThreads) {
+            m_supervisor = std::jthread{ [this] { supervise(); } };
         }
     }
 
@@ -72,6 +525,15 @@ public:
     template <typename... Args, std::invocable<Args...> Func>
     [[nodiscard]] auto enqueue(Func&& func, Args&&... args) -> std::future<std::invoke_result_t<Func, Args...>>
     {
+        return enqueue(Priority::Normal, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    // in WorkStealing mode a task with a priority other than Normal always goes to the shared queue, even when
+    // enqueued from inside a task
+    template <typename... Args, std::invocable<Args...> Func>
+    [[nodiscard]] auto enqueue(Priority priority, Func&& func, Args&&... args)
+        -> std::future<std::invoke_result_t<Func, Args...>>
+    {
 #if USE_PACKAGED_TASK
         auto packagedTask = std::packaged_task<std::invoke_result_t<Func, Args...>()>{
             [func = std::forward<Func>(func), ... args = std::forward<Args>(args)]() mutable {
@@ -79,59 +541,298 @@ public:
             }
         };
         auto res = packagedTask.get_future();
-        {
-            std::unique_lock lock{ m_mutex };
-            m_tasks.emplace_back([packagedTask = std::move(packagedTask)]() mutable { packagedTask(); });
-        }
-        m_condition.notify_one();
+        auto task = [packagedTask = std::move(packagedTask)]() mutable { packagedTask(); };
+        push(threadpool_detail::makeTask(std::move(task)), priority);
 
         return res;
 #else
+        // the promise's shared state comes from the task arena as well
         using Return_type = std::invoke_result_t<Func, Args...>;
-        std::promise<Return_type> promise;
+        std::promise<Return_type> promise{ std::allocator_arg, threadpool_detail::ArenaAllocator<Return_type>{} };
 
         auto future{ promise.get_future() };
+        auto task = [promise  = std::move(promise),
+                     func     = std::forward<Func>(func),
+                     ... args = std::forward<Args>(args)]() mutable {
+            try {
+                if constexpr (std::same_as<Return_type, void>) {
+                    func(std::forward<Args>(args)...);
+                    promise.set_value();
+                } else {
+                    promise.set_value(func(std::forward<Args>(args)...));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        };
+        push(threadpool_detail::makeTask(std::move(task)), priority);
+
+        return future;
+#endif
+    }
+
+    // calls func(i) for every i in [begin, end), split into chunks of grain indices each submitted as one task. all the
+    // chunks are queued under a single lock. a grain of 0 picks one that gives every worker a few chunks. the future
+    // completes once every chunk is done, with the first exception thrown by func, if any.
+    template <std::integral Index, std::invocable<Index> Func>
+    [[nodiscard]] std::future<void> parallelFor(Index begin, Index end, Index grain, Func&& func)
+    {
+        if (begin >= end) {
+            std::promise<void> promise;
+            promise.set_value();
+            return promise.get_future();
+        }
+
+        auto size = static_cast<std::size_t>(end - begin);
+        auto step = static_cast<std::size_t>(grain);
+        if (step == 0) {
+            auto chunks = std::max(m_numWorkers.load(std::memory_order_relaxed), std::size_t{ 1 }) * 4;
+            step        = std::max((size + chunks - 1) / chunks, std::size_t{ 1 });
+        }
+        auto numChunks = (size + step - 1) / step;
+
+        struct State
         {
-            std::unique_lock lock{ m_mutex };
-            m_tasks.emplace_back([promise  = std::move(promise),
-                                  func     = std::forward<Func>(func),
-                                  ... args = std::forward<Args>(args)]() mutable {
-                try {
-                    if constexpr (std::same_as<Return_type, void>) {
-                        func(std::forward<Args>(args)...);
-                        promise.set_value();
-                    } else {
-                        promise.set_value(func(std::forward<Args>(args)...));
+            State(std::size_t count, std::decay_t<Func> func)
+                : m_completion{ count }
+                , m_func{ std::move(func) }
+            {
+            }
+
+            BulkCompletion     m_completion;
+            std::decay_t<Func> m_func;
+        };
+        auto state  = std::make_shared<State>(numChunks, std::forward<Func>(func));
+        auto future = state->m_completion.future();
+
+        auto tasks = TaskList{};
+        for (std::size_t offset = 0; offset < size; offset += step) {
+            auto first = static_cast<Index>(begin + static_cast<Index>(offset));
+            auto last  = static_cast<Index>(begin + static_cast<Index>(std::min(offset + step, size)));
+            tasks.pushBack(threadpool_detail::makeTask([state, first, last] {
+                auto chunk = [&] {
+                    for (auto i = first; i != last; ++i) {
+                        state->m_func(i);
                     }
-                } catch (...) {
-                    promise.set_exception(std::current_exception());
-                }
-            });
+                };
+                state->m_completion.run(chunk);
+            }));
         }
-        m_condition.notify_one();
+        pushAll(tasks);
 
         return future;
-#endif
     }
 
+    template <std::integral Index, std::invocable<Index> Func>
+    [[nodiscard]] std::future<void> parallelFor(Index begin, Index end, Func&& func)
+    {
+        return parallelFor(begin, end, Index{ 0 }, std::forward<Func>(func));
+    }
+
+    // submits every callable in range (moved out of it) as its own task, all under a single lock. the future
+    // completes once all of them are done, with the first exception thrown, if any.
+    template <std::ranges::input_range R>
+        requires std::invocable<std::ranges::range_value_t<R>&>
+    [[nodiscard]] std::future<void> enqueueBulk(R&& range)
+    {
+        using Func_type = std::ranges::range_value_t<R>;
+
+        auto funcs = std::vector<Func_type>{};
+        for (auto it = std::ranges::begin(range); it != std::ranges::end(range); ++it) {
+            funcs.push_back(std::ranges::iter_move(it));
+        }
+
+        if (funcs.empty()) {
+            std::promise<void> promise;
+            promise.set_value();
+            return promise.get_future();
+        }
+
+        auto completion = std::make_shared<BulkCompletion>(funcs.size());
+        auto future     = completion->future();
+
+        auto tasks = TaskList{};
+        for (auto& func : funcs) {
+            tasks.pushBack(threadpool_detail::makeTask([completion, func = std::move(func)]() mutable {
+                completion->run(func);
+            }));
+        }
+        pushAll(tasks);
+
+        return future;
+    }
+
+    // like enqueue, but nothing is returned: no promise or future is created for the task. an exception escaping func
+    // is given to the exception handler (see setExceptionHandler).
+    template <typename... Args, std::invocable<Args...> Func>
+    void post(Func&& func, Args&&... args)
+    {
+        post(Priority::Normal, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template <typename... Args, std::invocable<Args...> Func>
+    void post(Priority priority, Func&& func, Args&&... args)
+    {
+        auto task = [this, func = std::forward<Func>(func), ... args = std::forward<Args>(args)]() mutable {
+            try {
+                func(std::forward<Args>(args)...);
+            } catch (...) {
+                handleException(std::current_exception());
+            }
+        };
+        push(threadpool_detail::makeTask(std::move(task)), priority);
+    }
+
+    // co_await pool.schedule() suspends the calling coroutine and resumes it on a worker, costing one queue push
+    class ScheduleAwaiter
+    {
+    public:
+        ScheduleAwaiter(ThreadPool& pool, Priority priority)
+            : m_pool{ pool }
+            , m_priority{ priority }
+        {
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            auto resume = Resume{ handle, &m_cancelled };
+            try {
+                m_pool.push(threadpool_detail::makeTask(std::move(resume)), m_priority);
+            } catch (...) {
+                resume.m_handle = nullptr;    // not queued, the exception is thrown at the co_await instead
+                throw;
+            }
+        }
+
+        void await_resume() const
+        {
+            if (m_cancelled) {
+                auto what = "ThreadPool: stopped before the coroutine was resumed";
+                throw std::system_error{ std::make_error_code(std::errc::operation_canceled), what };
+            }
+        }
+
+    private:
+        // the queued task: resumes the coroutine when run, and also when destroyed without running, cancelled
+        struct Resume
+        {
+            Resume(std::coroutine_handle<> handle, bool* cancelled)
+                : m_handle{ handle }
+                , m_cancelled{ cancelled }
+            {
+            }
+
+            Resume(Resume&& other) noexcept
+                : m_handle{ std::exchange(other.m_handle, nullptr) }
+                , m_cancelled{ other.m_cancelled }
+            {
+            }
+
+            Resume& operator=(Resume&&) = delete;
+
+            ~Resume()
+            {
+                if (m_handle) {
+                    *m_cancelled = true;
+                    m_handle.resume();
+                }
+            }
+
+            void operator()() { std::exchange(m_handle, nullptr).resume(); }
+
+            std::coroutine_handle<> m_handle;
+            bool*                   m_cancelled;
+        };
+
+        ThreadPool& m_pool;
+        Priority    m_priority;
+        bool        m_cancelled = false;
+    };
+
+    // a coroutine still queued when the pool is stopped with ignoreQueuedTasks is resumed on the thread calling
+    // stopPool, with the co_await throwing std::system_error (operation_canceled), so whoever awaits it (or syncWait)
+    // sees the exception instead of waiting forever. it must not schedule on the stopped pool again.
+    [[nodiscard]] ScheduleAwaiter schedule(Priority priority = Priority::Normal) { return { *this, priority }; }
+
+    // called on the worker thread that ran the task. without a handler the exception is printed to stderr.
+    void setExceptionHandler(ExceptionHandler_type handler)
+    {
+        std::unique_lock lock{ m_mutex };
+        m_exceptionHandler = std::move(handler);
+    }
+
+    // a queued task is raised one lane for every interval it has waited, 100ms by default, and at most one task per
+    // interval is taken ahead of a higher lane that way. zero disables aging
+    void setAgingInterval(Clock_type::duration interval)
+    {
+        std::unique_lock lock{ m_mutex };
+        m_tasks.setAging(interval);
+    }
+
+#if THREADPOOL_METRICS
+    // reads every worker's counters without taking any lock or stopping the workers. the counters are read one by one,
+    // so a snapshot taken while tasks run may be off by the tasks finishing meanwhile
+    PoolMetrics metrics() const
+    {
+        auto now     = Clock_type::now();
+        auto metrics = PoolMetrics{};
+        for (std::size_t i = 0; i < m_maxThreads; ++i) {
+            metrics.workers.push_back(m_metrics[i].snapshot(now));
+        }
+        return metrics;
+    }
+#endif
+
+    // the number of running workers, which changes over time with elastic sizing
+    std::size_t numThreads() const { return m_numWorkers.load(std::memory_order_relaxed); }
+
     std::size_t queuedTasks()
     {
+        auto count = localQueuedTasks();
+
+        std::unique_lock lock{ m_mutex };
+        return count + m_tasks.size();
+    }
+
+    // the depth of one lane, tasks in the workers' own deques (WorkStealing mode) are counted as Normal
+    std::size_t queuedTasks(Priority priority)
+    {
+        auto count = priority == Priority::Normal ? localQueuedTasks() : 0;
+
         std::unique_lock lock{ m_mutex };
-        return m_tasks.size();
+        return count + m_tasks.size(priority);
     }
 
     // after this call, the instance will effectively become unusable.
     // create a new instance if you want to use ThreadPool again.
     void stopPool(bool ignoreQueuedTasks = false)
     {
+        auto dropped = TaskList{};
         {
             std::unique_lock lock{ m_mutex };
             if (ignoreQueuedTasks) {
-                m_tasks.clear();
+                m_tasks.takeAll(dropped);
+                m_injected.store(0, std::memory_order_relaxed);
+                m_urgent.store(0, std::memory_order_relaxed);
+                for (std::size_t i = 0; i < m_numQueues; ++i) {
+                    std::unique_lock localLock{ m_localQueues[i].m_mutex };
+                    dropped.splice(m_localQueues[i].m_tasks);
+                }
             }
             m_stop = true;
+            ++m_wakeups;
         }
         m_condition.notify_all();
+        m_supervisorCondition.notify_all();
+
+        // outside the lock: destroying a task may resume a coroutine (see schedule), which runs until it suspends
+        dropped.clear();
+
+        if (m_supervisor.joinable()) {
+            m_supervisor.join();
+        }
 
         // for some reason, this prevents stray func destructor to be ran
         for (auto& thread : m_threads) {
@@ -140,6 +841,438 @@ public:
             }
         }
     }
+
+private:
+    void handleException(std::exception_ptr exception)
+    {
+        auto handler = [&] {
+            std::unique_lock lock{ m_mutex };
+            return m_exceptionHandler;
+        }();
+
+        if (handler) {
+            handler(exception);
+            return;
+        }
+
+        try {
+            std::rethrow_exception(exception);
+        } catch (const std::exception& e) {
+            std::cerr << std::format("ThreadPool: exception escaped a posted task: {}\n", e.what());
+        } catch (...) {
+            std::cerr << "ThreadPool: unknown exception escaped a posted task\n";
+        }
+    }
+
+    std::size_t localQueuedTasks()
+    {
+        auto count = std::size_t{ 0 };
+        for (std::size_t i = 0; i < m_numQueues; ++i) {
+            std::unique_lock lock{ m_localQueues[i].m_mutex };
+            count += m_localQueues[i].m_tasks.size();
+        }
+        return count;
+    }
+
+    void push(TaskNode* task, Priority priority = Priority::Normal)
+    {
+        auto tasks = TaskList{};
+        tasks.pushBack(task);
+        pushAll(tasks, priority);
+    }
+
+    // moves all of tasks into the queue under a single lock and wakes as many workers as needed
+    void pushAll(TaskList& tasks, Priority priority = Priority::Normal)
+    {
+        auto count = tasks.size();
+        auto now   = Clock_type::now();
+
+        if (m_scheduling == Scheduling::GlobalQueue) {
+            {
+                std::unique_lock lock{ m_mutex };
+                m_tasks.push(tasks, priority, now);
+                growIfLagging(now);
+                if (std::exchange(m_supervisorIdle, false)) {
+                    m_supervisorCondition.notify_one();
+                }
+            }
+            notify(count);
+            return;
+        }
+
+        auto worker = std::optional<std::size_t>{};
+        if (priority == Priority::Normal) {
+            worker = s_currentPool == this ? std::optional{ s_currentWorker } : nodeLocalWorker();
+        }
+        if (worker) {
+#if THREADPOOL_METRICS
+            tasks.forEach([&](TaskNode& task) { task.m_queued = now; });
+#endif
+            auto& queue = m_localQueues[*worker];
+            {
+                std::unique_lock lock{ queue.m_mutex };
+                queue.m_tasks.splice(tasks);
+            }
+            wake(count, false);
+            return;
+        }
+
+        std::unique_lock lock{ m_mutex };
+        m_tasks.push(tasks, priority, now);
+        m_injected.store(m_tasks.size(), std::memory_order_relaxed);
+        m_urgent.store(m_tasks.size(Priority::High), std::memory_order_relaxed);
+        wake(count, true);
+    }
+
+    // best effort: a worker the kernel refuses to pin still runs, just anywhere
+    static void pinCurrentThread(const std::vector<int>& cpus)
+    {
+        if (!cpus.empty()) {
+            CpuTopology::setCurrentThreadAffinity(cpus);
+        }
+    }
+
+    // GlobalQueue mode, with m_mutex held (or from the constructor)
+    void spawnWorker()
+    {
+        // the workers that retired since the last spawn have returned already, joining them is quick
+        for (auto id : std::exchange(m_retired, {})) {
+            auto retired = std::ranges::find(m_threads, id, &std::jthread::get_id);
+            retired->join();
+            m_threads.erase(retired);
+        }
+
+        auto slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_threads.emplace_back([this, slot] {
+            pinCurrentThread(m_workerCpus[slot]);
+            globalWorker(slot);
+        });
+        m_numWorkers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // called with m_mutex held after tasks were pushed or taken: adds a worker if the queue is lagging behind
+    void growIfLagging(Clock_type::time_point now)
+    {
+        if (m_maxThreads == m_minThreads || m_stop || m_tasks.empty()) {
+            return;
+        }
+        if (m_freeSlots.empty() || m_sleeping.load() != 0) {
+            return;
+        }
+        if (now - m_tasks.oldest() < m_spawnLatency || now - m_lastSpawn < m_spawnLatency) {
+            return;
+        }
+        m_lastSpawn = now;
+        spawnWorker();
+    }
+
+    // elastic sizing: rechecks growIfLagging whenever the oldest queued task is due, which a push or pop alone
+    // misses when every worker is busy with a long task
+    void supervise()
+    {
+        std::unique_lock lock{ m_mutex };
+        while (!m_stop) {
+            auto now = Clock_type::now();
+            growIfLagging(now);
+
+            // woken by the next push, or with every slot taken, by a worker retiring
+            if (m_tasks.empty() || m_freeSlots.empty()) {
+                m_supervisorIdle = m_tasks.empty();
+                m_supervisorCondition.wait(lock);
+                m_supervisorIdle = false;
+                continue;
+            }
+
+            // a deadline already past means an idle worker has yet to take the task, check again a bit later
+            auto deadline = std::max(m_tasks.oldest(), m_lastSpawn) + m_spawnLatency;
+            m_supervisorCondition.wait_until(lock, deadline > now ? deadline : now + m_spawnLatency);
+        }
+    }
+
+    void globalWorker(std::size_t slot)
+    {
+        auto ready = [this] { return !m_tasks.empty() || m_stop; };
+        startMetrics(slot);
+
+        while (true) {
+            TaskNode* task = nullptr;
+            {
+                std::unique_lock lock{ m_mutex };
+
+                if (m_maxThreads == m_minThreads) {
+                    m_condition.wait(lock, ready);
+                } else if (!ready()) {
+                    // only the workers above the minimum retire, the others just wait again
+                    m_sleeping.fetch_add(1);
+                    auto woken = m_condition.wait_for(lock, m_keepAlive, ready);
+                    m_sleeping.fetch_sub(1);
+                    if (!woken) {
+                        if (m_numWorkers.load(std::memory_order_relaxed) > m_minThreads) {
+                            m_numWorkers.fetch_sub(1, std::memory_order_relaxed);
+                            m_retired.push_back(std::this_thread::get_id());
+                            stopMetrics(slot);
+                            m_freeSlots.push_back(slot);
+                            m_supervisorCondition.notify_one();
+                            return;
+                        }
+                        continue;
+                    }
+                }
+
+                if (m_stop && m_tasks.empty()) {
+                    stopMetrics(slot);
+                    return;
+                }
+
+                task = m_tasks.pop();
+                growIfLagging(Clock_type::now());
+            }
+            run(slot, task);
+        }
+    }
+
+    // the CPUs each worker is restricted to, empty for no restriction
+    std::vector<std::vector<int>> placeWorkers(std::size_t numThreads, const Options& options)
+    {
+        auto workerCpus = std::vector<std::vector<int>>(numThreads);
+        if (options.placement == Placement::None && options.cpus.empty()) {
+            return workerCpus;
+        }
+
+        auto topology = CpuTopology::discover();
+        auto allowed  = topology.cpus();
+        auto cpus     = options.cpus.empty() ? allowed : options.cpus;
+        for (auto cpu : cpus) {
+            if (!std::ranges::binary_search(allowed, cpu)) {
+                auto what = std::format("cpu {} is not available", cpu);
+                throw std::system_error{ std::make_error_code(std::errc::invalid_argument), what };
+            }
+        }
+        if (cpus.empty() || numThreads == 0) {
+            return workerCpus;
+        }
+
+        switch (options.placement) {
+        case Placement::None: {
+            std::ranges::fill(workerCpus, cpus);
+            break;
+        }
+        case Placement::PinCpus: {
+            for (std::size_t i = 0; i < numThreads; ++i) {
+                workerCpus[i] = { cpus[i % cpus.size()] };
+            }
+            break;
+        }
+        case Placement::SpreadNodes: {
+            // the nodes with a CPU in cpus, every CPU of such a node maps to it so a submitter on an unused CPU of
+            // the node still finds it
+            auto nodes = std::vector<std::vector<int>>{};
+            for (const auto& node : topology.nodes()) {
+                auto used = std::vector<int>{};
+                std::ranges::copy_if(node, std::back_inserter(used), [&](int cpu) {
+                    return std::ranges::find(cpus, cpu) != cpus.end();
+                });
+                if (used.empty()) {
+                    continue;
+                }
+                auto size = std::max(m_cpuNodes.size(), static_cast<std::size_t>(node.back()) + 1);
+                m_cpuNodes.resize(size, CpuTopology::s_unknownNode);
+                for (auto cpu : node) {
+                    m_cpuNodes[static_cast<std::size_t>(cpu)] = nodes.size();
+                }
+                nodes.push_back(std::move(used));
+            }
+
+            m_nodeWorkers.resize(nodes.size());
+            for (std::size_t i = 0; i < numThreads; ++i) {
+                workerCpus[i] = nodes[i % nodes.size()];
+                m_nodeWorkers[i % nodes.size()].push_back(i);
+            }
+            break;
+        }
+        }
+        return workerCpus;
+    }
+
+    // every other worker, those on the same node first
+    std::vector<std::vector<std::size_t>> stealOrder(std::size_t numThreads) const
+    {
+        auto order    = std::vector<std::vector<std::size_t>>(numThreads);
+        auto numNodes = std::max(m_nodeWorkers.size(), std::size_t{ 1 });
+        for (std::size_t index = 0; index < numThreads; ++index) {
+            for (std::size_t i = 1; i < numThreads; ++i) {
+                order[index].push_back((index + i) % numThreads);
+            }
+            std::ranges::stable_partition(order[index], [&](std::size_t other) {
+                return other % numNodes == index % numNodes;
+            });
+        }
+        return order;
+    }
+
+    // a worker on the calling thread's node, if the workers are spread over more than one
+    std::optional<std::size_t> nodeLocalWorker()
+    {
+        if (m_nodeWorkers.size() < 2 || m_scheduling != Scheduling::WorkStealing) {
+            return std::nullopt;
+        }
+        auto cpu = CpuTopology::currentCpu();
+        if (!cpu || static_cast<std::size_t>(*cpu) >= m_cpuNodes.size()) {
+            return std::nullopt;
+        }
+        auto node = m_cpuNodes[static_cast<std::size_t>(*cpu)];
+        if (node == CpuTopology::s_unknownNode) {
+            return std::nullopt;
+        }
+        auto& workers = m_nodeWorkers[node];
+        return workers[m_nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+    }
+
+    void notify(std::size_t count)
+    {
+        if (count >= m_numWorkers.load(std::memory_order_relaxed)) {
+            m_condition.notify_all();
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                m_condition.notify_one();
+            }
+        }
+    }
+
+    // called after count tasks were pushed in WorkStealing mode, wakes up to count sleeping workers. the seq_cst fence
+    // pairs with the m_sleeping increment in stealingWorker: either this sees the sleeper or the sleeper, rescanning
+    // the queues after announcing itself, sees the task.
+    void wake(std::size_t count, bool locked)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto sleeping = m_sleeping.load(std::memory_order_relaxed);
+        if (sleeping == 0) {
+            return;
+        }
+        if (locked) {
+            ++m_wakeups;
+        } else {
+            std::unique_lock lock{ m_mutex };
+            ++m_wakeups;
+        }
+        notify(std::min(count, sleeping));
+    }
+
+    // own deque from the back, then the injection queue, then the front of the other workers' deques (those on the
+    // same node first). high priority tasks in the injection queue are taken before the own deque.
+    TaskNode* takeTask(std::size_t index)
+    {
+        auto popShared = [this]() -> TaskNode* {
+            std::unique_lock lock{ m_mutex };
+            if (m_tasks.empty()) {
+                return nullptr;
+            }
+            auto* task = m_tasks.pop();
+            m_injected.store(m_tasks.size(), std::memory_order_relaxed);
+            m_urgent.store(m_tasks.size(Priority::High), std::memory_order_relaxed);
+            return task;
+        };
+
+        auto popFrom = [](LocalQueue& queue, bool back) -> TaskNode* {
+            std::unique_lock lock{ queue.m_mutex };
+            return back ? queue.m_tasks.popBack() : queue.m_tasks.popFront();
+        };
+
+        if (m_urgent.load(std::memory_order_relaxed) != 0) {
+            if (auto task = popShared()) {
+                return task;
+            }
+        }
+
+        if (auto task = popFrom(m_localQueues[index], true)) {
+            return task;
+        }
+
+        if (m_injected.load(std::memory_order_relaxed) != 0) {
+            if (auto task = popShared()) {
+                return task;
+            }
+        }
+
+        for (auto victim : m_victims[index]) {
+            if (auto task = popFrom(m_localQueues[victim], false)) {
+#if THREADPOOL_METRICS
+                m_metrics[index].steal();
+#endif
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void startMetrics([[maybe_unused]] std::size_t slot)
+    {
+#if THREADPOOL_METRICS
+        m_metrics[slot].start(Clock_type::now());
+#endif
+    }
+
+    void stopMetrics([[maybe_unused]] std::size_t slot)
+    {
+#if THREADPOOL_METRICS
+        m_metrics[slot].stop(Clock_type::now());
+#endif
+    }
+
+    // runs task on the worker of the given slot
+    void run([[maybe_unused]] std::size_t slot, TaskNode* task)
+    {
+#if THREADPOOL_METRICS
+        auto& counters = m_metrics[slot];
+        auto  start    = Clock_type::now();
+        counters.begin(start, task->m_queued);
+        threadpool_detail::runTask(task);
+        counters.end(Clock_type::now(), start);
+#else
+        threadpool_detail::runTask(task);
+#endif
+    }
+
+    void stealingWorker(std::size_t index)
+    {
+        s_currentPool   = this;
+        s_currentWorker = index;
+        startMetrics(index);
+
+        while (true) {
+            if (auto task = takeTask(index)) {
+                run(index, task);
+                continue;
+            }
+
+            std::unique_lock lock{ m_mutex };
+            auto wakeups = m_wakeups;
+            m_sleeping.fetch_add(1);
+            lock.unlock();
+
+            // rescan after announcing ourselves, a task pushed before that did not wake anyone
+            if (auto task = takeTask(index)) {
+                m_sleeping.fetch_sub(1);
+                run(index, task);
+                continue;
+            }
+
+            lock.lock();
+            m_condition.wait(lock, [&] { return m_wakeups != wakeups || m_stop; });
+            m_sleeping.fetch_sub(1);
+
+            if (m_stop && m_tasks.empty()) {
+                lock.unlock();
+                if (auto task = takeTask(index)) {
+                    run(index, task);
+                    continue;
+                }
+                stopMetrics(index);
+                return;
+            }
+        }
+    }
 };
 
 #endif /* end of include guard: THREADPOOL_HPP_YWONTBSQ */
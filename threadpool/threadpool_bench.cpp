@@ -0,0 +1,214 @@
+#include "threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <latch>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// counts every call to the global operator new, to check that submitting tasks does not allocate
+std::atomic<std::size_t> s_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+constexpr int s_tasks = 1 << 20;
+constexpr int s_depth = 20;    // the fan-out tree has 2^(s_depth + 1) - 1 tasks
+
+// s_tasks tiny tasks enqueued one by one from the main thread, returns tasks/s
+double external(std::size_t numThreads, ThreadPool::Scheduling scheduling)
+{
+    ThreadPool pool{ numThreads, scheduling };
+    std::latch done{ s_tasks };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < s_tasks; ++i) {
+        pool.post([&done] { done.count_down(); });
+    }
+    done.wait();
+    auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return s_tasks / duration.count();
+}
+
+// the same as external, but through enqueue: each task also gets a promise and the future is dropped
+double externalEnqueue(std::size_t numThreads)
+{
+    ThreadPool pool{ numThreads };
+    std::latch done{ s_tasks };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < s_tasks; ++i) {
+        std::ignore = pool.enqueue([&done] { done.count_down(); });
+    }
+    done.wait();
+    auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return s_tasks / duration.count();
+}
+
+constexpr int s_items = 1 << 22;
+constexpr int s_grain = 64;
+
+// a loop over s_items items split into chunks of s_grain, each chunk enqueued on its own and waited on through its
+// own future. returns items/s
+double loopEnqueue(std::size_t numThreads, std::vector<float>& items)
+{
+    ThreadPool pool{ numThreads };
+
+    auto start   = std::chrono::steady_clock::now();
+    auto futures = std::vector<std::future<void>>{};
+    for (int first = 0; first < s_items; first += s_grain) {
+        futures.push_back(pool.enqueue([&items, first] {
+            for (int i = first; i < first + s_grain; ++i) {
+                items[i] = items[i] * 0.5f + 1.0f;
+            }
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return s_items / duration.count();
+}
+
+// the same loop through parallelFor, with the same grain or an automatic one. returns items/s
+double loopParallelFor(std::size_t numThreads, std::vector<float>& items, int grain)
+{
+    ThreadPool pool{ numThreads };
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(0, s_items, grain, [&items](int i) { items[i] = items[i] * 0.5f + 1.0f; }).get();
+    auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return s_items / duration.count();
+}
+
+void spawn(ThreadPool& pool, std::latch& done, int depth)
+{
+    if (depth > 0) {
+        pool.post([&pool, &done, depth] { spawn(pool, done, depth - 1); });
+        pool.post([&pool, &done, depth] { spawn(pool, done, depth - 1); });
+    }
+    done.count_down();
+}
+
+// every task enqueues two more until s_depth, the way recursive divide and conquer does. returns tasks/s
+double fanOut(std::size_t numThreads, ThreadPool::Scheduling scheduling)
+{
+    ThreadPool pool{ numThreads, scheduling };
+
+    constexpr auto numTasks = (std::ptrdiff_t{ 1 } << (s_depth + 1)) - 1;
+    std::latch     done{ numTasks };
+
+    auto start = std::chrono::steady_clock::now();
+    pool.post([&pool, &done] { spawn(pool, done, s_depth); });
+    done.wait();
+    auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return static_cast<double>(numTasks) / duration.count();
+}
+
+// calls to operator new per task while submitting small tasks through post and enqueue, after a warm up round
+void allocations()
+{
+    ThreadPool pool{ 2 };
+
+    auto round = [&](auto&& submit) {
+        std::latch done{ s_tasks };
+        auto       before = s_allocations.load();
+        for (int i = 0; i < s_tasks; ++i) {
+            submit(done);
+        }
+        done.wait();
+        return static_cast<double>(s_allocations.load() - before) / s_tasks;
+    };
+
+    auto post = [&](std::latch& done) { pool.post([&done] { done.count_down(); }); };
+    auto enqueue = [&](std::latch& done) {
+        auto future = pool.enqueue([&done, i = 42] {
+            done.count_down();
+            return i;
+        });
+        std::ignore = future.get();
+    };
+
+    round(post);
+    std::cout << std::format("allocations per task: post {}", round(post));
+    round(enqueue);
+    std::cout << std::format(", enqueue + get {}\n\n", round(enqueue));
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (argc > 1) {
+        std::stringstream ss{ argv[1] };
+        ss >> maxThreads;
+    }
+
+    using Scheduling = ThreadPool::Scheduling;
+
+    allocations();
+
+    std::cout << std::format("tasks/s, {} tasks enqueued from outside the pool\n", s_tasks);
+    std::cout << std::format("{:>8} {:>16} {:>16}\n", "threads", "GlobalQueue", "WorkStealing");
+    for (std::size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        auto global   = external(numThreads, Scheduling::GlobalQueue);
+        auto stealing = external(numThreads, Scheduling::WorkStealing);
+        std::cout << std::format("{:>8} {:>16} {:>16}\n", numThreads, global, stealing);
+    }
+
+    std::cout << std::format("\ntasks/s, binary fan-out of depth {} enqueued from inside the pool\n", s_depth);
+    std::cout << std::format("{:>8} {:>16} {:>16}\n", "threads", "GlobalQueue", "WorkStealing");
+    for (std::size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        auto global   = fanOut(numThreads, Scheduling::GlobalQueue);
+        auto stealing = fanOut(numThreads, Scheduling::WorkStealing);
+        std::cout << std::format("{:>8} {:>16} {:>16}\n", numThreads, global, stealing);
+    }
+
+    std::cout << std::format("\ntasks/s, {} tasks enqueued from outside the pool, GlobalQueue\n", s_tasks);
+    std::cout << std::format("{:>8} {:>16} {:>16}\n", "threads", "enqueue", "post");
+    for (std::size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        auto enqueue = externalEnqueue(numThreads);
+        auto post    = external(numThreads, Scheduling::GlobalQueue);
+        std::cout << std::format("{:>8} {:>16} {:>16}\n", numThreads, enqueue, post);
+    }
+
+    auto items = std::vector<float>(s_items);
+
+    std::cout << std::format("\nitems/s, loop over {} items\n", s_items);
+    std::cout << std::format(
+        "{:>8} {:>20} {:>20} {:>20}\n", "threads", "enqueue per chunk", "parallelFor", "parallelFor (auto)"
+    );
+    for (std::size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        auto enqueue   = loopEnqueue(numThreads, items);
+        auto parallel  = loopParallelFor(numThreads, items, s_grain);
+        auto automatic = loopParallelFor(numThreads, items, 0);
+        std::cout << std::format("{:>8} {:>20} {:>20} {:>20}\n", numThreads, enqueue, parallel, automatic);
+    }
+}
@@ -0,0 +1,100 @@
+#define THREADPOOL_METRICS 1
+#include "threadpool.hpp"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+double toUs(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+void print(const std::string& name, const WorkerMetrics& metrics)
+{
+    std::cout << std::format(
+        "{}:\n"
+        "\ttasks / steals     : {} / {}\n"
+        "\tbusy / idle        : {} us / {} us\n"
+        "\tqueue latency p50  : <= {} us (p99 <= {} us)\n"
+        "\trun time p50       : <= {} us (p99 <= {} us)\n",
+        name,
+        metrics.tasksExecuted,
+        metrics.steals,
+        toUs(metrics.busyTime),
+        toUs(metrics.idleTime),
+        toUs(metrics.queueLatency.percentile(0.5)),
+        toUs(metrics.queueLatency.percentile(0.99)),
+        toUs(metrics.runTime.percentile(0.5)),
+        toUs(metrics.runTime.percentile(0.99))
+    );
+}
+
+// a burst of short tasks and a few long ones: the long ones show up in the run time tail, the burst in queue latency
+void saturated(ThreadPool::Scheduling scheduling, const std::string& name)
+{
+    ThreadPool pool{ 2, scheduling };
+
+    std::latch done{ 2000 + 4 };
+    for (int i = 0; i < 4; ++i) {
+        pool.post([&done] {
+            std::this_thread::sleep_for(20ms);
+            done.count_down();
+        });
+    }
+    for (int i = 0; i < 1000; ++i) {
+        // from inside the pool as well, so work stealing has something to steal
+        pool.post([&pool, &done] {
+            pool.post([&done] { done.count_down(); });
+            done.count_down();
+        });
+    }
+
+    // taken while the workers are busy, never blocks them
+    std::this_thread::sleep_for(10ms);
+    print(name + " while running, total", pool.metrics().total());
+
+    done.wait();
+    std::this_thread::sleep_for(10ms);
+
+    auto metrics = pool.metrics();
+    for (std::size_t i = 0; i < metrics.workers.size(); ++i) {
+        print(std::format("{} worker {}", name, i), metrics.workers[i]);
+    }
+    print(name + " total", metrics.total());
+}
+
+// the slot of a retired worker stops counting idle time until a worker runs on it again
+void retired()
+{
+    auto options = ThreadPool::Options{ .maxThreads = 2, .spawnLatency = 1ms, .keepAlive = 50ms };
+    ThreadPool pool{ 1, options };
+
+    for (int i = 0; i < 4; ++i) {
+        pool.post([] { std::this_thread::sleep_for(20ms); });
+    }
+    std::this_thread::sleep_for(200ms);
+
+    auto before = pool.metrics().workers;
+    std::this_thread::sleep_for(100ms);
+    auto after = pool.metrics().workers;
+
+    std::cout << std::format("retired: {} threads left\n", pool.numThreads());
+    for (std::size_t i = 0; i < after.size(); ++i) {
+        auto grown = toUs(after[i].idleTime - before[i].idleTime);
+        auto tasks = after[i].tasksExecuted;
+        std::cout << std::format("retired: slot {} ran {} tasks, idle grew {} us in 100 ms\n", i, tasks, grown);
+    }
+}
+
+int main()
+{
+    saturated(ThreadPool::Scheduling::GlobalQueue, "GlobalQueue");
+    saturated(ThreadPool::Scheduling::WorkStealing, "WorkStealing");
+    retired();
+}
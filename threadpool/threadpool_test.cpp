@@ -1,10 +1,13 @@
 #include "threadpool.hpp"
 
+#include <atomic>
 #include <format>
+#include <future>
+#include <latch>
 #include <ostream>
 #include <sstream>
+#include <stdexcept>
 #include <thread>
-#include <tuple>
 
 std::size_t getTheadIdAsInteger()
 {
@@ -14,7 +17,9 @@ std::size_t getTheadIdAsInteger()
 }
 
 auto mainThreadId = getTheadIdAsInteger();
-auto _            = std::ignore;
+
+// destroyed after main returns, after the function-local statics created during main
+ThreadPool s_staticPool{ 2 };
 
 template <typename... Args>
 void print(std::format_string<Args...> fmt, Args... args)
@@ -29,7 +34,7 @@ void demo(std::size_t numThread)
     ThreadPool threadPool{ numThread };
 
     using namespace std::chrono_literals;
-    _ = threadPool.enqueue([] {
+    threadPool.post([] {
         int counter = 10;
         while (counter--) {
             std::this_thread::sleep_for(100ms);
@@ -38,7 +43,7 @@ void demo(std::size_t numThread)
         print("task 0 done\n");
     });
 
-    _ = threadPool.enqueue([] {
+    threadPool.post([] {
         int counter = 10;
         while (counter--) {
             std::this_thread::sleep_for(250ms);
@@ -47,7 +52,7 @@ void demo(std::size_t numThread)
         print("task 1 done\n");
     });
 
-    _ = threadPool.enqueue([] {
+    threadPool.post([] {
         int counter = 10;
         while (counter--) {
             std::this_thread::sleep_for(700ms);
@@ -76,7 +81,7 @@ void demo(std::size_t numThread)
         return 42;
     });
 
-    _ = threadPool.enqueue([] {
+    threadPool.post([] {
         int counter = 10;
         while (counter--) {
             std::this_thread::sleep_for(100ms);
@@ -91,7 +96,7 @@ void demo(std::size_t numThread)
         print("main: threadPool queued tasks: {}\n", threadPool.queuedTasks());
     }
 
-    _ = threadPool.enqueue([] {
+    threadPool.post([] {
         int counter = 10;
         while (counter--) {
             std::this_thread::sleep_for(100ms);
@@ -173,7 +178,7 @@ void nonTrivialArgs(std::size_t numThread)
     Args args{ 100'000 };
 
     print("before enqueu: {}\n", args.str());
-    _ = threadPool.enqueue([args = std::move(args)]() mutable {
+    threadPool.post([args = std::move(args)]() mutable {
         int counter = 10;
         while (counter--) {
             args.push(counter);
@@ -191,6 +196,192 @@ void nonTrivialArgs(std::size_t numThread)
     }
 }
 
+void postExceptions(std::size_t numThread)
+{
+    ThreadPool threadPool{ numThread };
+
+    threadPool.post([] { throw std::runtime_error{ "no handler set yet" }; });
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+
+    threadPool.setExceptionHandler([](std::exception_ptr exception) {
+        try {
+            std::rethrow_exception(exception);
+        } catch (const std::exception& e) {
+            print("handler: caught '{}'\n", e.what());
+        }
+    });
+
+    for (int i = 0; i < 3; ++i) {
+        threadPool.post(
+            [](int i) {
+                if (i % 2 == 1) {
+                    throw std::runtime_error{ std::format("posted task {} failed", i) };
+                }
+                print("posted task {} ok\n", i);
+            },
+            i
+        );
+    }
+}
+
+void priorities(std::size_t numThread)
+{
+    using Priority = ThreadPool::Priority;
+
+    ThreadPool threadPool{ numThread };
+
+    // keep every worker busy so the tasks below are all queued before any of them runs
+    std::promise<void> gate;
+    auto               gateFuture = gate.get_future().share();
+    for (std::size_t i = 0; i < numThread; ++i) {
+        threadPool.post([gateFuture] { gateFuture.wait(); });
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        threadPool.post(Priority::Low, [i] { print("low {}\n", i); });
+        threadPool.post([i] { print("normal {}\n", i); });
+        threadPool.post(Priority::High, [i] { print("high {}\n", i); });
+    }
+    print(
+        "main: queued high {}, normal {}, low {}\n",
+        threadPool.queuedTasks(Priority::High),
+        threadPool.queuedTasks(Priority::Normal),
+        threadPool.queuedTasks(Priority::Low)
+    );
+    gate.set_value();
+
+    auto high = threadPool.enqueue(Priority::High, [] { return 1; });
+    print("main: high priority future: {}\n", high.get());
+}
+
+// a low priority task behind a long stream of high priority ones still runs once it has waited long enough
+void aging()
+{
+    using Priority = ThreadPool::Priority;
+    using namespace std::chrono_literals;
+
+    ThreadPool threadPool{ 1 };
+    threadPool.setAgingInterval(20ms);
+
+    std::promise<void> gate;
+    threadPool.post([future = gate.get_future()] { future.wait(); });
+
+    std::atomic<int> highRun = 0;
+    threadPool.post(Priority::Low, [&highRun] { print("aging: low ran after {} high tasks\n", highRun.load()); });
+    for (int i = 0; i < 100; ++i) {
+        threadPool.post(Priority::High, [&highRun] {
+            std::this_thread::sleep_for(1ms);
+            ++highRun;
+        });
+    }
+    gate.set_value();
+    threadPool.stopPool();
+}
+
+// a high priority task is not held up behind an aged backlog of low priority ones queued before it
+void agedBacklog()
+{
+    using Priority = ThreadPool::Priority;
+    using namespace std::chrono_literals;
+
+    ThreadPool threadPool{ 1 };
+    threadPool.setAgingInterval(20ms);
+
+    for (int i = 0; i < 100; ++i) {
+        threadPool.post(Priority::Low, [] { std::this_thread::sleep_for(5ms); });
+    }
+    std::this_thread::sleep_for(100ms);
+
+    auto queued  = ThreadPool::Clock_type::now();
+    auto started = threadPool.enqueue(Priority::High, [] { return ThreadPool::Clock_type::now(); });
+    auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(started.get() - queued);
+    print("aged backlog: high started after {}, {} low still queued\n", latency, threadPool.queuedTasks(Priority::Low));
+    threadPool.stopPool(true);
+}
+
+void placement(std::size_t numThread)
+{
+    auto topology = CpuTopology::discover();
+    for (std::size_t i = 0; i < topology.nodes().size(); ++i) {
+        print("placement: node {} has {} cpus, the first is {}\n", i, topology.nodes()[i].size(), topology.nodes()[i].front());
+    }
+
+    auto run = [&](const char* name, ThreadPool::Options options) {
+        // wait until every worker has a task so each one reports once. declared before the pool, whose destructor
+        // still runs the queued tasks
+        std::latch started{ static_cast<std::ptrdiff_t>(numThread) };
+        ThreadPool threadPool{ numThread, std::move(options) };
+
+        for (std::size_t i = 0; i < numThread; ++i) {
+            threadPool.post([&, name] {
+                started.arrive_and_wait();
+                auto allowed = CpuTopology::allowedCpus();
+                print("placement: {} worker on cpu {}, allowed {} cpus\n", name, ::sched_getcpu(), allowed.size());
+            });
+        }
+    };
+
+    using Placement = ThreadPool::Placement;
+    run("pinned", { .placement = Placement::PinCpus });
+    run("spread", { .scheduling = ThreadPool::Scheduling::WorkStealing, .placement = Placement::SpreadNodes });
+
+    try {
+        ThreadPool threadPool{ numThread, { .placement = Placement::PinCpus, .cpus = { CPU_SETSIZE - 1 } } };
+    } catch (const std::system_error& e) {
+        print("placement: {}\n", e.what());
+    }
+}
+
+// grows while the queue lags behind, shrinks back once the burst is over
+void elastic()
+{
+    using namespace std::chrono_literals;
+
+    auto options = ThreadPool::Options{ .maxThreads = 4, .spawnLatency = 5ms, .keepAlive = 200ms };
+    ThreadPool threadPool{ 1, options };
+
+    std::atomic<int> done = 0;
+    for (int i = 0; i < 40; ++i) {
+        threadPool.post([&done] {
+            std::this_thread::sleep_for(20ms);
+            ++done;
+        });
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        print("elastic: {} threads, {} queued, {} done\n", threadPool.numThreads(), threadPool.queuedTasks(), done.load());
+        std::this_thread::sleep_for(100ms);
+    }
+
+    // queued tasks still all run on stop, whatever the number of workers left
+    for (int i = 0; i < 10; ++i) {
+        threadPool.post([&done] {
+            std::this_thread::sleep_for(10ms);
+            ++done;
+        });
+    }
+    threadPool.stopPool();
+    print("elastic: stopped, {} done\n", done.load());
+
+    // a burst pushed while the only worker is stuck in a long task still grows the pool, nothing is pushed or popped
+    // after it
+    ThreadPool longTasks{ 1, options };
+    for (int i = 0; i < 4; ++i) {
+        longTasks.post([] { std::this_thread::sleep_for(300ms); });
+    }
+    std::this_thread::sleep_for(100ms);
+    print("elastic: long tasks, {} threads, {} queued\n", longTasks.numThreads(), longTasks.queuedTasks());
+}
+
+// the tasks are left queued for the destructor of the static pool, which runs them at exit
+void staticPool()
+{
+    static std::atomic<int> s_done = 0;
+    for (int i = 0; i < 200; ++i) {
+        s_staticPool.post([] { ++s_done; });
+    }
+}
+
 int main(int argc, char* argv[])
 {
     std::size_t numThread{ 2 };
@@ -203,5 +394,19 @@ int main(int argc, char* argv[])
 
     nonTrivialArgs(numThread);
 
+    postExceptions(numThread);
+
+    priorities(numThread);
+
+    aging();
+
+    agedBacklog();
+
+    placement(numThread);
+
+    elastic();
+
+    staticPool();
+
     return 0;
 }